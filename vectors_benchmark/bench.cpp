@@ -0,0 +1,312 @@
+//
+//  bench.cpp
+//  vectors_benchmark
+//
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// Replaced global allocation functions
+//  Every heap allocation in the process goes through here, so bytes_allocated in the report
+//  includes what the elements allocate (std::string buffers) and not only the vector storage.
+namespace {
+
+std::atomic<std::uint64_t> g_allocations {0};
+std::atomic<std::uint64_t> g_bytes {0};
+
+void* counted_alloc(std::size_t n) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(n, std::memory_order_relaxed);
+  if (n == 0) n = 1;
+  if (void* p = std::malloc(n)) return p;
+  throw std::bad_alloc();
+}
+
+void* counted_aligned_alloc(std::size_t n, std::size_t alignment) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(n, std::memory_order_relaxed);
+  void* p = nullptr;
+  if (posix_memalign(&p, std::max(alignment, sizeof(void*)), n ? n : 1) != 0) throw std::bad_alloc();
+  return p;
+}
+
+} // namespace
+
+void* operator new(std::size_t n) { return counted_alloc(n); }
+void* operator new[](std::size_t n) { return counted_alloc(n); }
+void* operator new(std::size_t n, std::align_val_t a) { return counted_aligned_alloc(n, std::size_t(a)); }
+void* operator new[](std::size_t n, std::align_val_t a) { return counted_aligned_alloc(n, std::size_t(a)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+
+namespace bench {
+
+bool options::selected(const std::string& case_name) const {
+  return filter.empty() || case_name.find(filter) != std::string::npos;
+}
+
+std::vector<std::size_t> options::sizes() const {
+  std::vector<std::size_t> out;
+  for (std::size_t n = 10; n <= max_n; n *= 10) {
+    if (n >= min_n) out.push_back(n);
+    if (n > max_n / 10) break;
+  }
+  return out;
+}
+
+unsigned options::threads() const {
+  if (max_threads) return max_threads;
+  unsigned hw = std::thread::hardware_concurrency();
+  return hw ? hw : 1;
+}
+
+std::vector<unsigned> options::thread_counts() const {
+  std::vector<unsigned> out;
+  for (unsigned t = 1; t < threads(); t *= 2) out.push_back(t);
+  out.push_back(threads());
+  return out;
+}
+
+global_counters global_allocations() {
+  return {g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed)};
+}
+
+tally& container_tally() {
+  thread_local tally t;
+  return t;
+}
+
+
+bool reset_peak_rss() {
+#if defined(__linux__)
+  std::ofstream clear("/proc/self/clear_refs");
+  if (!clear) return false;
+  clear << "5";
+  clear.flush();
+  return bool(clear);
+#else
+  return false;
+#endif
+}
+
+std::int64_t peak_rss_bytes() {
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) return std::int64_t(std::strtoll(line.c_str() + 6, nullptr, 10)) * 1024;
+  }
+#endif
+  return -1;
+}
+
+
+// cache_miss_counter
+#if defined(__linux__)
+cache_miss_counter::cache_miss_counter() {
+  perf_event_attr attr {};
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  fd_ = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+cache_miss_counter::~cache_miss_counter() {
+  if (fd_ >= 0) close(fd_);
+}
+
+void cache_miss_counter::start() {
+  if (fd_ < 0) return;
+  ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+  ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+std::int64_t cache_miss_counter::stop() {
+  if (fd_ < 0) return -1;
+  ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+  std::int64_t count = 0;
+  if (read(fd_, &count, sizeof(count)) != ssize_t(sizeof(count))) return -1;
+  return count;
+}
+#else
+cache_miss_counter::cache_miss_counter() {}
+cache_miss_counter::~cache_miss_counter() {}
+void cache_miss_counter::start() {}
+std::int64_t cache_miss_counter::stop() { return -1; }
+#endif
+
+
+// probe
+void probe::start() {
+  global_begin_ = global_allocations();
+  tally& t = container_tally();
+  tally_begin_ = t;
+  // peak is reported relative to what was live when the timed region started
+  t.peak_bytes = t.live_bytes;
+  misses_.start();
+  begin_ = clock::now();
+}
+
+void probe::stop() {
+  auto end = clock::now();
+  sample_.cache_misses = misses_.stop();
+  sample_.ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin_).count());
+  global_counters g = global_allocations();
+  sample_.allocations = g.allocations - global_begin_.allocations;
+  sample_.bytes_allocated = g.bytes - global_begin_.bytes;
+  const tally& t = container_tally();
+  sample_.reallocations = t.allocations - tally_begin_.allocations;
+  sample_.peak_bytes = t.peak_bytes - tally_begin_.live_bytes;
+}
+
+
+// reporter
+void reporter::add(measurement m) {
+  out_ << std::left << std::setw(16) << m.suite
+       << std::setw(20) << m.op
+       << std::setw(12) << m.type
+       << std::setw(16) << m.variant
+       << std::right << std::setw(11) << m.n
+       << std::setw(14) << std::fixed << std::setprecision(2) << m.ns_per_op() << " ns/op"
+       << std::setw(14) << m.best.bytes_allocated << " B"
+       << std::setw(8) << m.best.reallocations << " realloc";
+  if (m.best.cache_misses >= 0) out_ << std::setw(12) << m.best.cache_misses << " miss";
+  for (auto& kv : m.extra) out_ << "  " << kv.first << '=' << kv.second;
+  out_ << '\n';
+  out_.flush();
+  results_.push_back(std::move(m));
+}
+
+namespace {
+
+void write_json_string(std::ostream& out, const std::string& s) {
+  out << '"';
+  for (char c : s) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\t': out << "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out << buf;
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+} // namespace
+
+void reporter::write_json(std::ostream& out) const {
+  char date[32] = "";
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  out << "{\n  \"context\": {\n";
+  out << "    \"date\": ";
+  write_json_string(out, date);
+  out << ",\n    \"compiler\": ";
+  write_json_string(out, compiler_name());
+  out << ",\n    \"stdlib\": ";
+  write_json_string(out, stdlib_name());
+  out << ",\n    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << "\n  },\n";
+  out << "  \"benchmarks\": [";
+  out << std::setprecision(6) << std::defaultfloat;
+  for (std::size_t i = 0; i < results_.size(); ++i) {
+    const measurement& m = results_[i];
+    out << (i ? ",\n" : "\n") << "    {\"suite\": ";
+    write_json_string(out, m.suite);
+    out << ", \"op\": ";
+    write_json_string(out, m.op);
+    out << ", \"type\": ";
+    write_json_string(out, m.type);
+    out << ", \"variant\": ";
+    write_json_string(out, m.variant);
+    out << ", \"n\": " << m.n
+        << ", \"items\": " << m.items
+        << ", \"ns_per_op\": " << m.ns_per_op()
+        << ", \"ns_total\": " << m.best.ns
+        << ", \"bytes_allocated\": " << m.best.bytes_allocated
+        << ", \"allocations\": " << m.best.allocations
+        << ", \"reallocations\": " << m.best.reallocations
+        << ", \"peak_bytes\": " << m.best.peak_bytes
+        << ", \"cache_misses\": ";
+    if (m.best.cache_misses >= 0) out << m.best.cache_misses;
+    else out << "null";
+    for (auto& kv : m.extra) {
+      out << ", ";
+      write_json_string(out, kv.first);
+      out << ": ";
+      if (std::isfinite(kv.second)) out << kv.second;
+      else out << "null";
+    }
+    out << '}';
+  }
+  out << "\n  ]\n}\n";
+}
+
+
+std::vector<suite>& suites() {
+  static std::vector<suite> all;
+  return all;
+}
+
+std::string compiler_name() {
+#if defined(__clang__)
+  return "clang " __clang_version__;
+#elif defined(__GNUC__)
+  return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+  return "msvc " + std::to_string(_MSC_VER);
+#else
+  return "unknown";
+#endif
+}
+
+std::string stdlib_name() {
+#if defined(_LIBCPP_VERSION)
+  return "libc++ " + std::to_string(_LIBCPP_VERSION);
+#elif defined(__GLIBCXX__)
+  return "libstdc++ " + std::to_string(_GLIBCXX_RELEASE) + " (" + std::to_string(__GLIBCXX__) + ")";
+#elif defined(_MSVC_STL_VERSION)
+  return "msvc stl " + std::to_string(_MSVC_STL_VERSION);
+#else
+  return "unknown";
+#endif
+}
+
+} // namespace bench
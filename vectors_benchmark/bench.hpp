@@ -0,0 +1,266 @@
+//
+//  bench.hpp
+//  vectors_benchmark
+//
+// What?
+// A small microbenchmark harness for the std::vector demos in vectors_in_cpp/main.cpp
+// Every measurement reports ns/op, bytes allocated, allocation count, container reallocations
+// and (when perf counters are available) cache misses, and can be written out as JSON
+//
+// How?
+// - suites register themselves with a bench::registration object at namespace scope
+// - a suite runs each case through bench::run_case(), which repeats the case and keeps the fastest sample
+// - the case calls probe.start()/probe.stop() around the part that should be timed
+// - containers use bench::tally_allocator / bench::tally_resource so reallocations can be told apart
+//   from the allocations the elements make themselves (e.g. std::string)
+
+#ifndef bench_hpp
+#define bench_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// options
+//  Parsed from the command line in main.cpp and handed to every suite.
+struct options {
+  std::size_t min_n = 10;
+  std::size_t max_n = 1000000;
+  double min_time_s = 0.05;   // keep repeating a case until this much time was spent on it
+  unsigned max_reps = 50;
+  unsigned max_threads = 0;   // 0 = std::thread::hardware_concurrency()
+  std::string filter;         // substring of "suite/case" names to run
+  std::string json_path;      // empty = no JSON output
+
+  bool selected(const std::string& case_name) const;
+  // 10, 100, 1000 ... clamped to [min_n, max_n]
+  std::vector<std::size_t> sizes() const;
+  unsigned threads() const;
+  // 1, 2, 4 ... and threads() itself
+  std::vector<unsigned> thread_counts() const;
+};
+
+
+// Allocation counters
+//  global_counters() is fed by the replaced operator new/delete in bench.cpp, so it sees every heap allocation.
+//  container_tally() is fed only by tally_allocator and tally_resource, i.e. by the containers under test.
+struct global_counters {
+  std::uint64_t allocations = 0;
+  std::uint64_t bytes = 0;
+};
+global_counters global_allocations();
+
+struct tally {
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t live_bytes = 0;
+  std::uint64_t peak_bytes = 0;
+
+  void on_allocate(std::size_t n) {
+    ++allocations;
+    bytes += n;
+    live_bytes += n;
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+  }
+  void on_deallocate(std::size_t n) {
+    ++deallocations;
+    live_bytes -= n;
+  }
+};
+// One tally per thread; the benchmarks that use it are single threaded.
+tally& container_tally();
+
+template <class T>
+struct tally_allocator {
+  using value_type = T;
+
+  tally_allocator() noexcept = default;
+  template <class U> tally_allocator(const tally_allocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    container_tally().on_allocate(n * sizeof(T));
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    container_tally().on_deallocate(n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(const tally_allocator&, const tally_allocator&) noexcept { return true; }
+  friend bool operator!=(const tally_allocator&, const tally_allocator&) noexcept { return false; }
+};
+
+// tally_resource
+//  Same as tally_allocator, but as a std::pmr::memory_resource sitting in front of an upstream resource.
+class tally_resource : public std::pmr::memory_resource {
+public:
+  explicit tally_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+    : upstream_(upstream) {}
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    container_tally().on_allocate(bytes);
+    return upstream_->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    container_tally().on_deallocate(bytes);
+    upstream_->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+};
+
+
+// Peak resident set size
+//  reset_peak_rss() restarts the kernel's high-water mark (Linux, /proc/self/clear_refs) and
+//  peak_rss_bytes() reads it back (VmHWM). Both return false / -1 where that is not available.
+bool reset_peak_rss();
+std::int64_t peak_rss_bytes();
+
+
+// cache_miss_counter
+//  Wraps a perf_event_open() hardware counter. On systems (or sandboxes) without perf support
+//  available() is false and stop() returns -1.
+class cache_miss_counter {
+public:
+  cache_miss_counter();
+  ~cache_miss_counter();
+  cache_miss_counter(const cache_miss_counter&) = delete;
+  cache_miss_counter& operator=(const cache_miss_counter&) = delete;
+
+  bool available() const { return fd_ >= 0; }
+  void start();
+  std::int64_t stop();
+
+private:
+  int fd_ = -1;
+};
+
+
+// sample
+//  One measured run of a case
+struct sample {
+  double ns = 0;
+  std::uint64_t bytes_allocated = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t reallocations = 0;
+  std::uint64_t peak_bytes = 0;
+  std::int64_t cache_misses = -1;
+};
+
+struct measurement {
+  std::string suite;
+  std::string op;
+  std::string type;
+  std::string variant;          // allocator, container or implementation being compared
+  std::size_t n = 0;            // size of the container the op works on
+  std::uint64_t items = 0;      // number of operations (or elements processed) in one sample
+  sample best;
+  std::vector<std::pair<std::string, double>> extra;   // suite specific numbers (compression ratio, speedup ...)
+
+  double ns_per_op() const { return items ? best.ns / double(items) : best.ns; }
+};
+
+
+// probe
+//  Handed to a case; the case brackets the timed region with start()/stop().
+class probe {
+public:
+  void start();
+  void stop();
+  const sample& result() const { return sample_; }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  clock::time_point begin_;
+  global_counters global_begin_;
+  tally tally_begin_;
+  cache_miss_counter misses_;
+  sample sample_;
+};
+
+template <class T>
+inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+}
+
+inline void clobber_memory() {
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+// run_case()
+//  Calls fn(probe&) repeatedly until options::min_time_s was spent (or max_reps reached)
+//  and returns the fastest sample.
+template <class Fn>
+sample run_case(const options& opt, Fn&& fn) {
+  sample best;
+  double spent_ns = 0;
+  unsigned reps = 0;
+  do {
+    probe p;
+    fn(p);
+    const sample& s = p.result();
+    if (reps == 0 || s.ns < best.ns) best = s;
+    spent_ns += s.ns;
+    ++reps;
+  } while (spent_ns < opt.min_time_s * 1e9 && reps < opt.max_reps);
+  return best;
+}
+
+
+// reporter
+//  Collects measurements, prints them as a table as they arrive and writes the JSON report at the end.
+class reporter {
+public:
+  explicit reporter(std::ostream& out) : out_(out) {}
+
+  void add(measurement m);
+  const std::vector<measurement>& results() const { return results_; }
+  void write_json(std::ostream& out) const;
+
+private:
+  std::ostream& out_;
+  std::vector<measurement> results_;
+};
+
+
+// Suite registry
+using suite_fn = void (*)(const options&, reporter&);
+
+struct suite {
+  const char* name;
+  suite_fn run;
+};
+
+std::vector<suite>& suites();
+
+struct registration {
+  registration(const char* name, suite_fn run) { suites().push_back({name, run}); }
+};
+
+// Human readable compiler and standard library names for the JSON context block.
+std::string compiler_name();
+std::string stdlib_name();
+
+} // namespace bench
+
+#endif /* bench_hpp */
@@ -0,0 +1,74 @@
+//
+//  bench_arena.cpp
+//  vectors_benchmark
+//
+// What?
+// Allocator churn from short-lived std::pmr::vector<int>s, the pattern of every section of main.cpp,
+// on new_delete_resource, a per-thread arena_resource and thread_local_pool(), from 1 to N threads
+//
+// How?
+// Each thread builds and destroys `items` vectors of 3 to 100 ints (push_back growth included).
+// The arena is released every 1024 vectors, which is what a per-request arena would do.
+
+#include "arena.hpp"
+#include "bench.hpp"
+
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int churn(std::pmr::memory_resource* resource, std::size_t i) {
+  std::pmr::vector<int> v (resource);
+  std::size_t k = 3 + i % 98;
+  for (std::size_t j = 0; j < k; ++j) v.push_back(int(j));
+  return v.back();
+}
+
+void worker(const char* resource, std::size_t items) {
+  arena_resource arena;
+  std::pmr::memory_resource* r = std::pmr::new_delete_resource();
+  if (std::string(resource) == "arena") r = &arena;
+  else if (std::string(resource) == "pool") r = thread_local_pool();
+  int sink = 0;
+  for (std::size_t i = 0; i < items; ++i)
+  {
+    sink += churn(r, i);
+    if (r == &arena && i % 1024 == 1023) arena.release();
+  }
+  bench::do_not_optimize(sink);
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  const std::size_t items = 20000;
+  for (unsigned threads : opt.thread_counts())
+  {
+    for (const char* resource : {"new_delete", "arena", "pool"})
+    {
+      std::string case_name = std::string("arena/churn/int/") + resource;
+      if (!opt.selected(case_name)) continue;
+      bench::measurement m;
+      m.suite = "arena";
+      m.op = "churn";
+      m.type = "int";
+      m.variant = resource;
+      m.n = threads;
+      m.items = items * threads;
+      m.best = bench::run_case(opt, [&](bench::probe& p) {
+        std::vector<std::thread> pool;
+        p.start();
+        for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker, resource, items);
+        for (auto& t : pool) t.join();
+        p.stop();
+      });
+      m.extra.push_back({"threads", double(threads)});
+      rep.add(std::move(m));
+    }
+  }
+}
+
+bench::registration reg("arena", &run);
+
+} // namespace
@@ -0,0 +1,136 @@
+//
+//  bench_batch_erase.cpp
+//  vectors_benchmark
+//
+// What?
+// Removing a scattered 1%, 10% or 50% of a vector: the repeated erase() of vec_erase against the
+// one-pass batch_erase.hpp functions
+// - repeated_erase: erase(begin()+i) for every index, from the back so the others stay valid
+// - erase_indices / erase_mask / erase_if: batch_erase.hpp (erase_if tests the element's value)
+// - remove_if     : the plain std::remove_if + erase idiom, for reference
+// - mask_<isa>    : erase_mask's compaction for int with one specific simd::compress implementation
+//
+// How?
+// op is erase_<percent>pct, one item is one removed element; speedup is repeated_erase time / variant
+// time. repeated_erase is O(n * k) and skipped once n * k passes 10^9 element moves. Every variant is
+// checked once against std::remove_if on a copy before it is timed.
+
+#include "batch_erase.hpp"
+#include "bench.hpp"
+#include "bench_types.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// fixed pseudo-random choice of the removed elements, the same for every variant
+bool chosen(std::size_t i, unsigned percent) {
+  return (std::uint32_t(i) * 2654435761u >> 7) % 100 < percent;
+}
+
+int key(int x) { return x; }
+int key(const bench::pod64& x) { return int(x.v[0]); }
+int key(const std::string& x) { return std::stoi(x.substr(x.rfind(' ') + 1)); }
+
+template <class T>
+void scenario(const bench::options& opt, bench::reporter& rep, unsigned percent, const std::string& variant,
+              std::size_t n, double& baseline_ns) {
+  std::string op = "erase_" + std::to_string(percent) + "pct";
+  std::string case_name = "batch_erase/" + op + '/' + bench::type_name<T>::value + '/' + variant;
+  if (!opt.selected(case_name)) return;
+
+  std::vector<std::size_t> indices;
+  batch::removal_mask mask (n);
+  for (std::size_t i = 0; i < n; ++i)
+    if (chosen(i, percent)) {
+      indices.push_back(i);
+      mask.set(i);
+    }
+  if (indices.empty()) return;
+  if (variant == "repeated_erase" && double(n) * double(indices.size()) > 1e9) return;
+
+  const simd::kernels* k = nullptr;
+  if (variant.compare(0, 5, "mask_") == 0)
+  {
+    for (simd::isa i : {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+      if (variant == std::string("mask_") + simd::isa_name(i) && simd::supported(i)) k = &simd::kernels_for(i);
+    if (!k) return;
+  }
+
+  auto fill = [n](std::vector<T>& v) {
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) v.push_back(bench::make_value<T>(i));
+  };
+  auto pred = [percent](const T& x) { return chosen(std::size_t(key(x)), percent); };
+  auto erase = [&](std::vector<T>& v) {
+    if (variant == "repeated_erase")
+      for (auto it = indices.rbegin(); it != indices.rend(); ++it) v.erase(v.begin() + std::ptrdiff_t(*it));
+    else if (variant == "erase_indices") batch::erase_indices(v, indices);
+    else if (variant == "erase_mask") batch::erase_mask(v, mask);
+    else if (variant == "erase_if") batch::erase_if(v, pred);
+    else if (variant == "remove_if") v.erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+    else if constexpr (std::is_same<T, int>::value) v.resize(k->compress(v.data(), n, mask.words(), v.data()));
+  };
+
+  {
+    std::vector<T> v, expected;
+    fill(v);
+    expected = v;
+    expected.erase(std::remove_if(expected.begin(), expected.end(), pred), expected.end());
+    erase(v);
+    if (v != expected)
+    {
+      std::fprintf(stderr, "batch_erase: %s left other elements than remove_if (%s, n=%zu)\n", variant.c_str(),
+                   op.c_str(), n);
+      std::abort();
+    }
+  }
+
+  bench::measurement m;
+  m.suite = "batch_erase";
+  m.op = op;
+  m.type = bench::type_name<T>::value;
+  m.variant = variant;
+  m.n = n;
+  m.items = indices.size();
+  m.best = bench::run_case(opt, [&](bench::probe& p) {
+    std::vector<T> v;
+    fill(v);
+    p.start();
+    erase(v);
+    p.stop();
+    bench::do_not_optimize(v.data());
+  });
+  if (variant == "repeated_erase") baseline_ns = m.best.ns;
+  else if (baseline_ns > 0) m.extra.push_back({"speedup", baseline_ns / m.best.ns});
+  rep.add(std::move(m));
+}
+
+template <class T>
+void run_type(const bench::options& opt, bench::reporter& rep) {
+  std::vector<std::string> variants = {"repeated_erase", "erase_indices", "erase_mask", "erase_if", "remove_if"};
+  if (std::is_same<T, int>::value)
+    for (const char* v : {"mask_scalar", "mask_avx2", "mask_avx512"}) variants.push_back(v);
+  for (std::size_t n : opt.sizes())
+  {
+    for (unsigned percent : {1u, 10u, 50u})
+    {
+      double baseline_ns = 0;
+      for (const std::string& variant : variants) scenario<T>(opt, rep, percent, variant, n, baseline_ns);
+    }
+  }
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  run_type<int>(opt, rep);
+  run_type<bench::pod64>(opt, rep);
+  run_type<std::string>(opt, rep);
+}
+
+bench::registration reg("batch_erase", &run);
+
+} // namespace
@@ -0,0 +1,183 @@
+//
+//  bench_checked.cpp
+//  vectors_benchmark
+//
+// What?
+// What the checks of checked_vector<int> cost on each loop pattern of main.cpp, against std::vector<int>
+// (which is what hardened_vector<int> is in a release build)
+// - at_fill          : v.at(i) = i                                   (vec_at, checked on both)
+// - index_fill       : v[i] = i                                      (vec_at_op)
+// - index_reverse    : swap v[n-1-i] and v[i] for the first half     (vec_at_op)
+// - index_sum        : sum of v[i] for i < v.size()                  (vec_back, vec_clear, vec_erase ...)
+// - iter_sum         : for (it = v.begin(); it != v.end(); ++it)     (vec_begin, vec_swap)
+// - const_iter_sum   : the same with cbegin() / cend()               (vec_cbegin_cend)
+// - reverse_iter_sum : the same with crbegin() / crend()             (vec_crbegin_crend)
+// - range_for        : for (auto& x : v)                             (vec_emplace)
+// - back_push        : while (v.back() != 0) v.push_back(v.back()-1) (vec_back)
+// - pop_back_sum     : while (!v.empty()) { s += v.back(); v.pop_back(); } (vec_pop_back)
+// - insert           : it = v.insert(it, x), 64 times in the middle  (vec_insert)
+//
+// How?
+// One item is one element visited (one insert for insert). speedup is std_vector time / checked_vector
+// time, so 1 means the checks are free and 0.8 means they add 25%. Every vector is set up (and memory
+// reserved) before the clock starts; both variants are checked to compute the same result.
+
+#include "bench.hpp"
+#include "checked_vector.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t inserts = 64;
+
+template <class Vec>
+void prepare(const std::string& op, Vec& v, std::size_t n) {
+  if (op == "back_push")
+  {
+    v.reserve(n);
+    v.push_back(int(n - 1));
+    return;
+  }
+  v.resize(n);
+  for (std::size_t i = 0; i < n; ++i) v[i] = int(i);
+  if (op == "insert") v.reserve(n + inserts);
+}
+
+template <class Vec>
+std::int64_t run_op(const std::string& op, Vec& v) {
+  std::int64_t s = 0;
+  const std::size_t sz = v.size();
+  if (op == "at_fill")
+  {
+    for (std::size_t i = 0; i < v.size(); i++) v.at(i) = int(i);
+    return v.at(sz - 1);
+  }
+  if (op == "index_fill")
+  {
+    for (std::size_t i = 0; i < sz; i++) v[i] = int(i);
+    return v[sz - 1];
+  }
+  if (op == "index_reverse")
+  {
+    for (std::size_t i = 0; i < sz / 2; i++)
+    {
+      int temp = v[sz - 1 - i];
+      v[sz - 1 - i] = v[i];
+      v[i] = temp;
+    }
+    return v[0];
+  }
+  if (op == "index_sum")
+  {
+    for (std::size_t i = 0; i < v.size(); i++) s += v[i];
+    return s;
+  }
+  if (op == "iter_sum")
+  {
+    for (typename Vec::iterator it = v.begin(); it != v.end(); ++it) s += *it;
+    return s;
+  }
+  if (op == "const_iter_sum")
+  {
+    for (auto it = v.cbegin(); it != v.cend(); ++it) s += *it;
+    return s;
+  }
+  if (op == "reverse_iter_sum")
+  {
+    for (auto rit = v.crbegin(); rit != v.crend(); ++rit) s += *rit;
+    return s;
+  }
+  if (op == "range_for")
+  {
+    for (auto& x : v) s += x;
+    return s;
+  }
+  if (op == "back_push")
+  {
+    while (v.back() != 0) v.push_back(v.back() - 1);
+    return std::int64_t(v.size());
+  }
+  if (op == "pop_back_sum")
+  {
+    while (!v.empty())
+    {
+      s += v.back();
+      v.pop_back();
+    }
+    return s;
+  }
+  typename Vec::iterator it = v.begin() + typename Vec::difference_type(sz / 2);
+  for (std::size_t i = 0; i < inserts; ++i) it = v.insert(it, int(i));
+  return *it + std::int64_t(v.size());
+}
+
+template <class Vec>
+std::int64_t run_once(const std::string& op, std::size_t n) {
+  Vec v;
+  prepare(op, v, n);
+  return run_op(op, v);
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  const char* ops[] = {"at_fill", "index_fill", "index_reverse", "index_sum", "iter_sum", "const_iter_sum",
+                       "reverse_iter_sum", "range_for", "back_push", "pop_back_sum", "insert"};
+  for (std::size_t n : opt.sizes())
+  {
+    for (const char* op : ops)
+    {
+      const std::string which = op;
+      if (run_once<std::vector<int>>(which, n) != run_once<checked_vector<int>>(which, n))
+      {
+        std::fprintf(stderr, "checked: %s differs between std::vector and checked_vector (n=%zu)\n", op, n);
+        std::abort();
+      }
+      double std_ns = 0;
+      for (const char* variant : {"std_vector", "checked_vector"})
+      {
+        const bool checked = std::string(variant) == "checked_vector";
+        std::string case_name = std::string("checked/") + op + "/int/" + variant;
+        if (!opt.selected(case_name)) continue;
+
+        bench::measurement m;
+        m.suite = "checked";
+        m.op = op;
+        m.type = "int";
+        m.variant = variant;
+        m.n = n;
+        m.items = which == "insert" ? inserts : n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          std::vector<int> plain;
+          checked_vector<int> hardened;
+          std::int64_t r;
+          if (checked)
+          {
+            prepare(which, hardened, n);
+            p.start();
+            r = run_op(which, hardened);
+            p.stop();
+          }
+          else
+          {
+            prepare(which, plain, n);
+            p.start();
+            r = run_op(which, plain);
+            p.stop();
+          }
+          bench::do_not_optimize(r);
+        });
+        if (!checked) std_ns = m.best.ns;
+        else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+}
+
+bench::registration reg("checked", &run);
+
+} // namespace
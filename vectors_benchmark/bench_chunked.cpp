@@ -0,0 +1,163 @@
+//
+//  bench_chunked.cpp
+//  vectors_benchmark
+//
+// What?
+// The emplace(), insert() and erase() sections of main.cpp on large sequences, std::vector against
+// chunked_vector, as the position and the size vary
+// - insert      : 1000 single inserts at front (begin()+1, as in vec_emplace), middle or back
+// - insert_n    : 1000 times insert(it, 2, value), the fill insert of vec_insert
+// - insert_range: 1000 times insert(it, array, array+3), the range insert of vec_insert
+// - erase       : 1000 single erases at front (begin()+5, as in vec_erase), middle or back
+// - erase_range : 1000 times erase(begin(), begin()+3), the range erase of vec_erase
+// - iterate     : summing all elements through iterators, and per chunk ("chunks" position),
+//                 which is what the chunked layout costs
+//
+// How?
+// n is the size of the sequence the ops work on, one item is one insert/erase (one element for
+// iterate). speedup is std::vector time / chunked_vector time for the same case. chunks is how many
+// chunks chunked_vector holds after a sample and fill how full they are on average (1 = full), which
+// shows whether inserts keep the chunks between ~1/4 and full.
+
+#include "bench.hpp"
+#include "bench_types.hpp"
+#include "chunked_vector.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t ops_per_sample = 1000;
+
+template <class Vec>
+std::size_t position(const Vec& v, const std::string& where, std::size_t front_offset) {
+  if (where == "front") return std::min(front_offset, v.size());
+  if (where == "middle") return v.size() / 2;
+  return v.size();
+}
+
+template <class Vec>
+std::int64_t run_op(Vec& v, const std::string& op, const std::string& where) {
+  using T = typename Vec::value_type;
+  std::int64_t sink = 0;
+  if (op == "insert")
+  {
+    const T value = bench::make_value<T>(7);
+    for (std::size_t i = 0; i < ops_per_sample; ++i)
+      v.insert(v.begin() + std::ptrdiff_t(position(v, where, 1)), value);
+  }
+  else if (op == "insert_n")
+  {
+    const T value = bench::make_value<T>(7);
+    for (std::size_t i = 0; i < ops_per_sample; ++i)
+      v.insert(v.begin() + std::ptrdiff_t(position(v, where, 1)), 2, value);
+  }
+  else if (op == "insert_range")
+  {
+    const T data_array[] = {bench::make_value<T>(501), bench::make_value<T>(502), bench::make_value<T>(503)};
+    for (std::size_t i = 0; i < ops_per_sample; ++i)
+      v.insert(v.begin() + std::ptrdiff_t(position(v, where, 1)), data_array, data_array + 3);
+  }
+  else if (op == "erase")
+  {
+    for (std::size_t i = 0; i < ops_per_sample; ++i)
+    {
+      std::size_t p = position(v, where, 5);
+      if (p == v.size()) --p;
+      v.erase(v.begin() + std::ptrdiff_t(p));
+    }
+  }
+  else if (op == "erase_range")
+  {
+    for (std::size_t i = 0; i < ops_per_sample; ++i) v.erase(v.begin(), v.begin() + 3);
+  }
+  else if constexpr (std::is_same<T, int>::value)
+  {
+    if (where == "chunks")
+    {
+      if constexpr (std::is_same<Vec, std::vector<int>>::value) for (int x : v) sink += x;
+      else v.for_each_chunk([&sink](const int* p, std::size_t n) { for (std::size_t i = 0; i < n; ++i) sink += p[i]; });
+    }
+    else
+    {
+      for (auto it = v.begin(); it != v.end(); ++it) sink += *it;
+    }
+  }
+  return sink + std::int64_t(v.size());
+}
+
+// returns the best time, 0 if filtered out; baseline_ns > 0 adds the speedup column
+template <class Vec>
+double scenario(const bench::options& opt, bench::reporter& rep, const char* op, const char* where, const char* variant,
+                std::size_t n, double baseline_ns) {
+  using T = typename Vec::value_type;
+  std::string case_name = std::string("chunked/") + op + '_' + where + '/' + bench::type_name<T>::value + '/' + variant;
+  if (!opt.selected(case_name)) return 0;
+  const std::string which = op;
+  const bool iterate = which == "iterate";
+  // erases need the elements they remove on top of n
+  const std::size_t initial = which == "erase" ? n + ops_per_sample : which == "erase_range" ? n + 3 * ops_per_sample : n;
+
+  bench::measurement m;
+  m.suite = "chunked";
+  m.op = std::string(op) + '_' + where;
+  m.type = bench::type_name<T>::value;
+  m.variant = variant;
+  m.n = n;
+  m.items = iterate ? n : ops_per_sample;
+  std::size_t chunks = 0;
+  double fill = 0;
+  m.best = bench::run_case(opt, [&](bench::probe& p) {
+    Vec v;
+    for (std::size_t i = 0; i < initial; ++i) v.push_back(bench::make_value<T>(i));
+    p.start();
+    std::int64_t r = run_op(v, which, where);
+    p.stop();
+    bench::do_not_optimize(r);
+    if constexpr (!std::is_same<Vec, std::vector<T>>::value)
+    {
+      chunks = v.chunk_count();
+      fill = double(v.size()) / double(chunks * Vec::chunk_capacity);
+    }
+  });
+  if (baseline_ns > 0) m.extra.push_back({"speedup", baseline_ns / m.best.ns});
+  if (chunks > 0)
+  {
+    m.extra.push_back({"chunks", double(chunks)});
+    m.extra.push_back({"fill", fill});
+  }
+  double ns = m.best.ns;
+  rep.add(std::move(m));
+  return ns;
+}
+
+template <class T>
+void run_type(const bench::options& opt, bench::reporter& rep) {
+  const std::pair<const char*, const char*> cases[] = {
+    {"insert", "front"}, {"insert", "middle"}, {"insert", "back"},
+    {"insert_n", "front"}, {"insert_n", "middle"}, {"insert_n", "back"},
+    {"insert_range", "front"}, {"insert_range", "middle"}, {"insert_range", "back"},
+    {"erase", "front"}, {"erase", "middle"}, {"erase", "back"},
+    {"erase_range", "front"},
+    {"iterate", "all"}, {"iterate", "chunks"},
+  };
+  for (std::size_t n : opt.sizes())
+  {
+    for (const auto& c : cases)
+    {
+      if (std::string(c.first) == "iterate" && !std::is_same<T, int>::value) continue;
+      double std_ns = scenario<std::vector<T>>(opt, rep, c.first, c.second, "std_vector", n, 0);
+      scenario<chunked_vector<T>>(opt, rep, c.first, c.second, "chunked_vector", n, std_ns);
+    }
+  }
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  run_type<int>(opt, rep);
+  run_type<std::string>(opt, rep);
+}
+
+bench::registration reg("chunked", &run);
+
+} // namespace
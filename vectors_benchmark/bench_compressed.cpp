@@ -0,0 +1,140 @@
+//
+//  bench_compressed.cpp
+//  vectors_benchmark
+//
+// What?
+// compressed_vector<int> against plain std::vector<int> on three kinds of data
+// - sorted_ids : increasing, gaps of 0..255 (mostly sorted IDs: delta blocks, 8 bits or less)
+// - small_ints : 0..15 in any order (frame-of-reference blocks, 4 bits)
+// - random     : all 32 bits in use (nothing to gain: 32-bit blocks plus headers)
+// Ops
+// - scan   : sum of every element; std_vector and compressed_vector_blocks sum with simd::sum (one
+//            block at a time for the latter), compressed_vector through its iterators
+// - at     : 4096 reads at random positions
+// - append : push_back of n elements into an empty vector
+//
+// How?
+// One item is one element (one read for at). speedup is std_vector time / variant time, ratio is
+// the compression ratio (plain bytes / compressed bytes). Scans of data that compresses well gain
+// once the plain vector no longer fits in cache; in cache the decode work is extra.
+
+#include "bench.hpp"
+#include "compressed_vector.hpp"
+#include "simd_kernels.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t lookups = 4096;
+
+std::uint32_t next_random(std::uint64_t& x) {
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return std::uint32_t(x >> 16);
+}
+
+std::vector<int> make_data(const std::string& type, std::size_t n) {
+  std::vector<int> v(n);
+  std::uint64_t x = 0x9e3779b97f4a7c15ull;
+  int id = 1000000;
+  for (int& e : v)
+  {
+    std::uint32_t r = next_random(x);
+    if (type == "sorted_ids") e = id += int(r % 256);
+    else if (type == "small_ints") e = int(r % 16);
+    else e = int(r);
+  }
+  return v;
+}
+
+std::vector<std::size_t> make_positions(std::size_t n) {
+  std::vector<std::size_t> out(lookups);
+  std::uint64_t x = 0x2545f4914f6cdd1dull;
+  for (std::size_t& p : out) p = next_random(x) % n;
+  return out;
+}
+
+std::int64_t run_std(const std::string& op, const std::vector<int>& data, const std::vector<std::size_t>& at) {
+  if (op == "scan") return simd::sum(data);
+  std::int64_t s = 0;
+  if (op == "at")
+  {
+    for (std::size_t i : at) s += data.at(i);
+    return s;
+  }
+  std::vector<int> out;
+  for (int e : data) out.push_back(e);
+  return std::int64_t(out.size()) + out.back();
+}
+
+std::int64_t run_compressed(const std::string& op, const std::string& variant, const compressed_vector<int>& v,
+                            const std::vector<int>& data, const std::vector<std::size_t>& at) {
+  std::int64_t s = 0;
+  if (op == "scan")
+  {
+    if (variant == "compressed_vector_blocks") v.for_each_block([&s](const int* p, std::size_t n) { s += simd::sum(p, n); });
+    else for (int e : v) s += e;
+    return s;
+  }
+  if (op == "at")
+  {
+    for (std::size_t i : at) s += v.at(i);
+    return s;
+  }
+  compressed_vector<int> out;
+  for (int e : data) out.push_back(e);
+  return std::int64_t(out.size()) + out.back();
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  for (std::size_t n : opt.sizes())
+  {
+    const std::vector<std::size_t> at = make_positions(n);
+    for (const char* type : {"sorted_ids", "small_ints", "random"})
+    {
+      const std::vector<int> data = make_data(type, n);
+      const compressed_vector<int> packed(data.begin(), data.end());
+      for (const char* op : {"scan", "at", "append"})
+      {
+        const std::string which = op;
+        double std_ns = 0;
+        for (const char* variant : {"std_vector", "compressed_vector", "compressed_vector_blocks"})
+        {
+          const std::string kind = variant;
+          if (kind == "compressed_vector_blocks" && which != "scan") continue;
+          std::string case_name = std::string("compressed/") + op + "/" + type + "/" + variant;
+          if (!opt.selected(case_name)) continue;
+
+          bench::measurement m;
+          m.suite = "compressed";
+          m.op = op;
+          m.type = type;
+          m.variant = variant;
+          m.n = n;
+          m.items = which == "at" ? lookups : n;
+          m.best = bench::run_case(opt, [&](bench::probe& p) {
+            p.start();
+            std::int64_t r = kind == "std_vector" ? run_std(which, data, at) : run_compressed(which, kind, packed, data, at);
+            p.stop();
+            bench::do_not_optimize(r);
+          });
+          if (kind == "std_vector") std_ns = m.best.ns;
+          else
+          {
+            if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+            m.extra.push_back({"ratio", packed.compression_ratio()});
+          }
+          rep.add(std::move(m));
+        }
+      }
+    }
+  }
+}
+
+bench::registration reg("compressed", &run);
+
+} // namespace
@@ -0,0 +1,172 @@
+//
+//  bench_concurrent.cpp
+//  vectors_benchmark
+//
+// What?
+// Many threads appending to one shared vector, the push_back/emplace_back sections of main.cpp under
+// contention: a std::vector behind a std::mutex against concurrent_vector
+// - push_back/int       : v.push_back(i)
+// - emplace_back/string : v.emplace_back(...) of a heap-allocated string
+// Variants are mutex_std_vector, concurrent_vector, and concurrent_vector_reserved (reserve(n) first,
+// so no append allocates a segment).
+//
+// How?
+// One item is one append; n appends in total are split evenly over t threads ("..._t<t>"), t going
+// from 1 to 64 (or --threads if higher) whatever the core count, since a lock holder losing its core is
+// part of what is measured. speedup is mutex_std_vector time / variant time for the same t.
+// Before timing, every thread count runs a stress check: the producers append while a reader walks
+// [0, size()) and checks each element, then every value must be there exactly once; any failure aborts.
+// Build with -fsanitize=thread and run --filter=concurrent/ to have ThreadSanitizer watch it.
+
+#include "bench.hpp"
+#include "bench_types.hpp"
+#include "concurrent_vector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// runs body(thread_index) on t threads started together; the time from start to the last one finishing
+template <class Body>
+void run_threads(bench::probe& p, unsigned t, Body body) {
+  std::atomic<unsigned> waiting {t};
+  std::atomic<bool> go {false};
+  std::vector<std::thread> threads;
+  threads.reserve(t);
+  for (unsigned k = 0; k < t; ++k)
+    threads.emplace_back([&, k] {
+      waiting.fetch_sub(1);
+      while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+      body(k);
+    });
+  while (waiting.load() != 0) std::this_thread::yield();
+  p.start();
+  go.store(true, std::memory_order_release);
+  for (auto& th : threads) th.join();
+  p.stop();
+}
+
+void fail(const char* what, unsigned t, std::size_t n) {
+  std::fprintf(stderr, "concurrent: %s with %u threads, n=%zu\n", what, t, n);
+  std::abort();
+}
+
+void stress(unsigned t, std::size_t n) {
+  const std::size_t per_thread = n / t;
+  concurrent_vector<std::size_t> v;
+  std::atomic<bool> done {false};
+  std::atomic<bool> bad {false};
+  std::thread reader([&] {
+    std::size_t seen = 0;
+    while (!done.load(std::memory_order_acquire) || seen < v.size())
+    {
+      std::size_t size = v.size();
+      for (; seen < size; ++seen)
+        if (v[seen] >= per_thread * t) bad.store(true);
+    }
+  });
+  std::vector<std::thread> producers;
+  for (unsigned k = 0; k < t; ++k)
+    producers.emplace_back([&, k] {
+      for (std::size_t i = 0; i < per_thread; ++i)
+      {
+        const std::size_t value = k * per_thread + i;
+        std::size_t& r = v.emplace_back(value);
+        if (r != value) bad.store(true);
+      }
+    });
+  for (auto& th : producers) th.join();
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  if (bad.load()) fail("an element read back wrong", t, n);
+  if (v.size() != per_thread * t) fail("size() is not the number of appends", t, n);
+  std::vector<std::size_t> values (v.begin(), v.end());
+  std::sort(values.begin(), values.end());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    if (values[i] != i) fail("a value is missing or duplicated", t, n);
+}
+
+template <class T>
+void scenario(const bench::options& opt, bench::reporter& rep, const char* op, const std::string& kind, unsigned t,
+              std::size_t n, double& mutex_ns) {
+  const std::string variant = kind + "_t" + std::to_string(t);
+  std::string case_name = std::string("concurrent/") + op + '/' + bench::type_name<T>::value + '/' + variant;
+  if (!opt.selected(case_name)) return;
+  const std::size_t per_thread = n / t;
+
+  bench::measurement m;
+  m.suite = "concurrent";
+  m.op = op;
+  m.type = bench::type_name<T>::value;
+  m.variant = variant;
+  m.n = n;
+  m.items = per_thread * t;
+  m.best = bench::run_case(opt, [&](bench::probe& p) {
+    if (kind == "mutex_std_vector")
+    {
+      std::vector<T> v;
+      std::mutex mutex;
+      run_threads(p, t, [&](unsigned k) {
+        for (std::size_t i = 0; i < per_thread; ++i)
+        {
+          T value = bench::make_value<T>(k * per_thread + i);
+          std::lock_guard<std::mutex> lock (mutex);
+          v.push_back(std::move(value));
+        }
+      });
+      bench::do_not_optimize(v.data());
+    }
+    else
+    {
+      concurrent_vector<T> v;
+      if (kind == "concurrent_vector_reserved") v.reserve(n);
+      run_threads(p, t, [&](unsigned k) {
+        for (std::size_t i = 0; i < per_thread; ++i) v.emplace_back(bench::make_value<T>(k * per_thread + i));
+      });
+      bench::do_not_optimize(v.back());
+    }
+  });
+  m.extra.push_back({"threads", double(t)});
+  if (kind == "mutex_std_vector") mutex_ns = m.best.ns;
+  else if (mutex_ns > 0) m.extra.push_back({"speedup", mutex_ns / m.best.ns});
+  rep.add(std::move(m));
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  std::vector<unsigned> thread_counts;
+  for (unsigned t = 1; t <= std::max(64u, opt.threads()); t *= 2) thread_counts.push_back(t);
+
+  for (std::size_t n : opt.sizes())
+  {
+    if (n < 10000) continue;
+    for (unsigned t : thread_counts)
+    {
+      bool any = false;
+      for (const char* c : {"push_back/int/concurrent_vector", "emplace_back/string/concurrent_vector"})
+        any = any || opt.selected(std::string("concurrent/") + c + "_t" + std::to_string(t)) ||
+                     opt.selected(std::string("concurrent/") + c + "_reserved_t" + std::to_string(t));
+      if (any) stress(t, std::min<std::size_t>(n, 200000));
+      for (const char* op : {"push_back", "emplace_back"})
+      {
+        double mutex_ns = 0;
+        for (const char* kind : {"mutex_std_vector", "concurrent_vector", "concurrent_vector_reserved"})
+        {
+          if (std::string(op) == "push_back") scenario<int>(opt, rep, op, kind, t, n, mutex_ns);
+          else scenario<std::string>(opt, rep, op, kind, t, n, mutex_ns);
+        }
+      }
+    }
+  }
+}
+
+bench::registration reg("concurrent", &run);
+
+} // namespace
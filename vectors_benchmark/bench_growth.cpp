@@ -0,0 +1,101 @@
+//
+//  bench_growth.cpp
+//  vectors_benchmark
+//
+// What?
+// The growth scenarios of main.cpp (vec_capacity: push_back from empty, vec_shrink_to_fit: shrink after
+// resize) on std::vector and on growth_vector with each growth policy
+//
+// How?
+// Besides ns/op the extra columns show
+// - peak_rss_mb: how far the process high-water mark rose during the sample (Linux only), which is
+//                where copying growth briefly needs old + new buffer and mremap growth does not
+// - growths    : how many times the capacity changed (counted in a separate, untimed run)
+
+#include "bench.hpp"
+#include "bench_types.hpp"
+#include "growth_vector.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+template <class Vec>
+std::size_t count_growths(std::size_t n) {
+  using T = typename Vec::value_type;
+  Vec v;
+  std::size_t growths = 0;
+  std::size_t capacity = v.capacity();
+  const T value = bench::make_value<T>(1);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    v.push_back(value);
+    if (v.capacity() != capacity) ++growths;
+    capacity = v.capacity();
+  }
+  return growths;
+}
+
+template <class Vec>
+void scenario(const bench::options& opt, bench::reporter& rep, const char* op, const char* variant, std::size_t n,
+              bool huge_pages = true) {
+  using T = typename Vec::value_type;
+  std::string case_name = std::string("growth/") + op + '/' + bench::type_name<T>::value + '/' + variant;
+  if (!opt.selected(case_name)) return;
+  const bool shrink = std::string(op) == "shrink_to_fit";
+
+  std::int64_t peak_rss = -1;
+  bench::measurement m;
+  m.suite = "growth";
+  m.op = op;
+  m.type = bench::type_name<T>::value;
+  m.variant = variant;
+  m.n = n;
+  m.items = shrink ? n / 10 : n;
+  m.best = bench::run_case(opt, [&](bench::probe& p) {
+    Vec v;
+    if constexpr (!std::is_same<Vec, std::vector<T, bench::tally_allocator<T>>>::value) v.set_huge_pages(huge_pages);
+    const T value = bench::make_value<T>(1);
+    if (shrink)
+    {
+      v.resize(n);
+      v.resize(n / 10);
+    }
+    std::int64_t rss_before = bench::reset_peak_rss() ? bench::peak_rss_bytes() : -1;
+    p.start();
+    if (shrink) v.shrink_to_fit();
+    else for (std::size_t i = 0; i < n; ++i) v.push_back(value);
+    p.stop();
+    if (rss_before >= 0) peak_rss = bench::peak_rss_bytes() - rss_before;
+    bench::do_not_optimize(v.data());
+  });
+  if (peak_rss >= 0) m.extra.push_back({"peak_rss_mb", double(peak_rss) / (1 << 20)});
+  if (!shrink) m.extra.push_back({"growths", double(count_growths<Vec>(n))});
+  rep.add(std::move(m));
+}
+
+template <class T>
+void run_type(const bench::options& opt, bench::reporter& rep) {
+  for (std::size_t n : opt.sizes())
+  {
+    for (const char* op : {"push_back", "shrink_to_fit"})
+    {
+      scenario<std::vector<T, bench::tally_allocator<T>>>(opt, rep, op, "std_vector", n);
+      scenario<growth_vector<T, geometric_growth<2,1>>>(opt, rep, op, "growth_2x", n);
+      scenario<growth_vector<T, geometric_growth<2,1>>>(opt, rep, op, "growth_2x_nothp", n, false);
+      scenario<growth_vector<T, geometric_growth<3,2>>>(opt, rep, op, "growth_1.5x", n);
+      scenario<growth_vector<T, chunk_growth<65536>>>(opt, rep, op, "growth_chunk64k", n);
+      scenario<growth_vector<T, exact_growth>>(opt, rep, op, "growth_exact", n);
+    }
+  }
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  run_type<int>(opt, rep);
+  run_type<bench::pod64>(opt, rep);
+}
+
+bench::registration reg("growth", &run);
+
+} // namespace
@@ -0,0 +1,207 @@
+//
+//  bench_io.cpp
+//  vectors_benchmark
+//
+// What?
+// Saving and loading a std::vector<int> of n elements through a file
+// - iostream_text   : one element per line with std::ofstream << / std::ifstream >>, what the cout
+//                     loops of main.cpp do
+// - to_chars_text   : the same text, formatted with std::to_chars / parsed with std::from_chars through
+//                     a 64 KiB buffer and plain write() / read()
+// - vector_io       : one binary frame, vector_io::write / vector_io::read
+// - vector_io_crc32c: the same with the CRC-32C checksum computed and verified
+// - vector_io_stream: read only, vector_io::frame_reader in chunks of 16 Ki elements, summed as they
+//                     arrive instead of kept (the frame never has to fit in memory)
+// The ops are write (open, write, close) and read (open, read and parse, close).
+//
+// How?
+// One item is one element. speedup is iostream_text time / variant time. Each reader is checked
+// against the data before it is timed. The files live in the temp directory, normally in the page
+// cache, so this measures formatting and copying, not the disk; they are removed afterwards. Writes
+// overwrite the file of the previous sample in place: truncating it would free and refault its pages,
+// which costs more than the formatting at small n.
+
+#include "bench.hpp"
+#include "vector_io.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t text_buffer = 64 * 1024;
+
+std::vector<int> make_data(std::size_t n) {
+  std::vector<int> v(n);
+  // mixed signs and widths, as real data would have
+  for (std::size_t i = 0; i < n; ++i) v[i] = int((i * 2654435761u) % 2000003) - 1000000;
+  return v;
+}
+
+int open_write(const std::string& path) { return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644); }
+int open_read(const std::string& path) { return ::open(path.c_str(), O_RDONLY | O_CLOEXEC); }
+
+void write_text_iostream(const std::string& path, const std::vector<int>& v) {
+  std::ofstream out (path, std::ios::in | std::ios::out);   // no truncation, like open_write
+  if (!out) out.open(path);
+  for (int x : v) out << x << '\n';
+}
+
+void write_text_to_chars(const std::string& path, const std::vector<int>& v) {
+  int fd = open_write(path);
+  std::vector<char> buffer (text_buffer);
+  std::size_t used = 0;
+  for (int x : v)
+  {
+    if (used + 16 > buffer.size())
+    {
+      if (::write(fd, buffer.data(), used) != ssize_t(used)) std::perror("write");
+      used = 0;
+    }
+    char* end = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), x).ptr;
+    *end++ = '\n';
+    used = std::size_t(end - buffer.data());
+  }
+  if (used && ::write(fd, buffer.data(), used) != ssize_t(used)) std::perror("write");
+  ::close(fd);
+}
+
+std::vector<int> read_text_iostream(const std::string& path) {
+  std::vector<int> v;
+  std::ifstream in (path);
+  for (int x; in >> x;) v.push_back(x);
+  return v;
+}
+
+// a number cut by the end of a chunk is moved to the front of the buffer and finished with the next
+std::vector<int> read_text_from_chars(const std::string& path) {
+  std::vector<int> v;
+  int fd = open_read(path);
+  std::vector<char> buffer (text_buffer);
+  std::size_t kept = 0;
+  for (;;)
+  {
+    ssize_t got = ::read(fd, buffer.data() + kept, buffer.size() - kept);
+    if (got <= 0) break;
+    const char* p = buffer.data();
+    const char* end = p + kept + std::size_t(got);
+    const char* last_newline = end;
+    while (last_newline != p && last_newline[-1] != '\n') --last_newline;
+    while (p < last_newline)
+    {
+      int x;
+      p = std::from_chars(p, last_newline, x).ptr;
+      v.push_back(x);
+      ++p;   // '\n'
+    }
+    kept = std::size_t(end - last_newline);
+    std::memmove(buffer.data(), last_newline, kept);
+  }
+  ::close(fd);
+  return v;
+}
+
+std::int64_t run_write(const std::string& kind, const std::string& path, const std::vector<int>& v) {
+  if (kind == "iostream_text") write_text_iostream(path, v);
+  else if (kind == "to_chars_text") write_text_to_chars(path, v);
+  else
+  {
+    int fd = open_write(path);
+    vector_io::write(fd, v, kind == "vector_io_crc32c" ? vector_io::checksum::crc32c : vector_io::checksum::none);
+    ::close(fd);
+  }
+  return std::int64_t(v.size());
+}
+
+std::int64_t run_read(const std::string& kind, const std::string& path) {
+  std::vector<int> v;
+  if (kind == "iostream_text") v = read_text_iostream(path);
+  else if (kind == "to_chars_text") v = read_text_from_chars(path);
+  else if (kind == "vector_io_stream")
+  {
+    int fd = open_read(path);
+    vector_io::frame_reader in (fd);
+    std::vector<int> chunk (16 * 1024);
+    std::int64_t sum = 0;
+    while (in.next())
+      while (std::size_t n = in.read(chunk.data(), chunk.size()))
+        for (std::size_t i = 0; i < n; ++i) sum += chunk[i];
+    ::close(fd);
+    return sum;
+  }
+  else
+  {
+    int fd = open_read(path);
+    vector_io::read(fd, v);
+    ::close(fd);
+  }
+  return v.empty() ? 0 : std::int64_t(v.size()) + v.back();
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  const std::string stem = std::filesystem::temp_directory_path().string() + "/vectors_benchmark_io_" + std::to_string(::getpid());
+  for (std::size_t n : opt.sizes())
+  {
+    const std::vector<int> data = make_data(n);
+    for (const char* op : {"write", "read"})
+    {
+      const std::string which = op;
+      double text_ns = 0;
+      for (const char* variant : {"iostream_text", "to_chars_text", "vector_io", "vector_io_crc32c", "vector_io_stream"})
+      {
+        const std::string kind = variant;
+        if (kind == "vector_io_stream" && which == "write") continue;
+        std::string case_name = std::string("io/") + op + "/int/" + variant;
+        if (!opt.selected(case_name)) continue;
+
+        // the text variants share a format, the stream reads the checksummed frame; the file is
+        // written fresh, so the readers see exactly what one write produced
+        const std::string path = stem + (kind.find("text") != std::string::npos ? ".txt" : kind == "vector_io" ? ".bin" : ".crc");
+        std::remove(path.c_str());
+        run_write(kind == "vector_io_stream" ? "vector_io_crc32c" : kind, path, data);
+        if (which == "read")
+        {
+          std::int64_t expected = kind == "vector_io_stream" ? std::accumulate(data.begin(), data.end(), std::int64_t(0))
+                                                             : std::int64_t(n) + data.back();
+          if (run_read(kind, path) != expected)
+          {
+            std::fprintf(stderr, "io: %s read back something else than was written (n=%zu)\n", variant, n);
+            std::abort();
+          }
+        }
+
+        bench::measurement m;
+        m.suite = "io";
+        m.op = op;
+        m.type = "int";
+        m.variant = variant;
+        m.n = n;
+        m.items = n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          p.start();
+          std::int64_t r = which == "write" ? run_write(kind, path, data) : run_read(kind, path);
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        if (kind == "iostream_text") text_ns = m.best.ns;
+        else if (text_ns > 0) m.extra.push_back({"speedup", text_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+  for (const char* ext : {".txt", ".bin", ".crc"}) std::remove((stem + ext).c_str());
+}
+
+bench::registration reg("io", &run);
+
+} // namespace
@@ -0,0 +1,171 @@
+//
+//  bench_mmap.cpp
+//  vectors_benchmark
+//
+// What?
+// Start-up cost of getting a saved vector of int back: loading it into a std::vector against opening
+// it as an mmap_vector
+// - std_vector_text: parse a text file of numbers with operator>>, one push_back each
+// - std_vector_read: read() the mmap_vector file (header, then the raw array) into a std::vector
+// - mmap_vector    : open the same file read-only
+// - mmap_vector_seq: the same, advised mmap_access::sequential before use
+// The ops are
+// - open_cold: ready to use, first and last element read, with the file evicted from the page cache
+// - sum_cold : open then sum every element, file evicted
+// - sum_warm : open then sum every element, file already in the page cache
+//
+// How?
+// One item is one element. speedup is std_vector_read time / variant time. The files are written to
+// the temp directory once per size and removed afterwards. "Evicted" is posix_fadvise(DONTNEED) on the
+// file before each sample: no root needed, but a file system that ignores it shows warm numbers.
+
+#include "bench.hpp"
+#include "mmap_vector.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+struct files {
+  std::string text;
+  std::string binary;
+};
+
+files write_files(std::size_t n) {
+  std::string dir = std::filesystem::temp_directory_path().string();
+  std::string stem = dir + "/vectors_benchmark_" + std::to_string(::getpid()) + '_' + std::to_string(n);
+  files f{stem + ".txt", stem + ".vec"};
+  {
+    std::ofstream out (f.text);
+    for (std::size_t i = 0; i < n; ++i) out << int(i * 7) << '\n';
+  }
+  mmap_vector<int> v (f.binary, mmap_mode::create);
+  v.resize(n);
+  for (std::size_t i = 0; i < n; ++i) v[i] = int(i * 7);
+  v.shrink_to_fit();
+  v.sync();
+  return f;
+}
+
+// clean pages only: the files were synced when written and are never written again
+void evict(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+#if defined(POSIX_FADV_DONTNEED)
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  ::close(fd);
+}
+
+std::vector<int> load_text(const std::string& path) {
+  std::vector<int> v;
+  std::ifstream in (path);
+  for (int x; in >> x;) v.push_back(x);
+  return v;
+}
+
+std::vector<int> load_binary(const std::string& path) {
+  std::vector<int> v;
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return v;
+  mmap_detail::file_header h;
+  if (::read(fd, &h, sizeof(h)) == ssize_t(sizeof(h)))
+  {
+    v.resize(std::size_t(h.size));
+    char* p = reinterpret_cast<char*>(v.data());
+    std::size_t left = v.size() * sizeof(int);
+    while (left > 0)
+    {
+      ssize_t got = ::read(fd, p, left);
+      if (got <= 0) break;
+      p += got;
+      left -= std::size_t(got);
+    }
+  }
+  ::close(fd);
+  return v;
+}
+
+template <class Vec>
+std::int64_t use(const Vec& v, bool sum) {
+  if (v.empty()) return 0;
+  if (!sum) return std::int64_t(v.front()) + v.back();
+  std::int64_t total = 0;
+  for (int x : v) total += x;
+  return total;
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  for (std::size_t n : opt.sizes())
+  {
+    bool have_files = false;
+    files f;
+    for (const char* op : {"open_cold", "sum_cold", "sum_warm"})
+    {
+      const std::string which = op;
+      const bool cold = which != "sum_warm";
+      const bool sum = which != "open_cold";
+      double read_ns = 0;
+      for (const char* variant : {"std_vector_read", "std_vector_text", "mmap_vector", "mmap_vector_seq"})
+      {
+        std::string case_name = std::string("mmap/") + op + "/int/" + variant;
+        if (!opt.selected(case_name)) continue;
+        if (!have_files)
+        {
+          f = write_files(n);
+          have_files = true;
+        }
+        const std::string kind = variant;
+        const std::string& path = kind == "std_vector_text" ? f.text : f.binary;
+
+        bench::measurement m;
+        m.suite = "mmap";
+        m.op = op;
+        m.type = "int";
+        m.variant = variant;
+        m.n = n;
+        m.items = n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          if (cold) evict(path);
+          std::int64_t r;
+          p.start();
+          if (kind == "std_vector_text")
+          {
+            r = use(load_text(path), sum);
+          }
+          else if (kind == "std_vector_read")
+          {
+            r = use(load_binary(path), sum);
+          }
+          else
+          {
+            mmap_vector<int> v (path, mmap_mode::read_only);
+            if (kind == "mmap_vector_seq") v.advise(mmap_access::sequential);
+            r = use(v, sum);
+          }
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        if (kind == "std_vector_read") read_ns = m.best.ns;
+        else if (read_ns > 0) m.extra.push_back({"speedup", read_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+    if (have_files)
+    {
+      std::remove(f.text.c_str());
+      std::remove(f.binary.c_str());
+    }
+  }
+}
+
+bench::registration reg("mmap", &run);
+
+} // namespace
@@ -0,0 +1,144 @@
+//
+//  bench_parallel.cpp
+//  vectors_benchmark
+//
+// What?
+// Scaling of the parallel.hpp bulk operations on large vectors of int, from 1 to N threads
+// - fill          : assign(n, value) on an existing vector
+// - resize        : resize(n, 100) of an empty vector; std::vector (value-initialized on one thread,
+//                   then written by the pool) against first_touch_vector (only written by the pool,
+//                   on a pool with pinned workers, which first-touch placement relies on).
+//                   A non-zero value, since malloc + memset(0) may legally become calloc and touch nothing
+// - for_each_index: the vec_at loop, v[i] = i
+// - equal / less  : operator== on equal vectors, operator< on vectors differing in the last element
+// - sum           : the accumulate loop
+//
+// How?
+// "serial" is the plain single-threaded loop or std algorithm, except for equal, less and sum where it
+// is simd::equal / simd::less / simd::sum, the kernels the pool runs on each chunk. "pool_t<k>" runs on
+// a k-way work_stealing_pool with the default grain; for the largest thread count sum and fill are also
+// run with grains of 1k, 16k and 256k elements ("pool_t<k>_g<grain>"). speedup is serial time / variant
+// time, so for equal, less and sum it is what the threads add on top of the same kernel.
+// Only sizes of 10^5 and up are run, below that there is nothing to split.
+
+#include "bench.hpp"
+#include "parallel.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+using int_vector = std::vector<int>;
+
+struct variant {
+  std::string name;
+  parallel::work_stealing_pool* pool;   // null for serial
+  std::size_t grain;
+  bool first_touch;
+};
+
+std::int64_t run_op(const std::string& op, const variant& v, int_vector& a, int_vector& b, std::size_t n) {
+  if (op == "fill")
+  {
+    if (v.pool) parallel::fill(*v.pool, a, 100, v.grain);
+    else std::fill(a.begin(), a.end(), 100);
+    return a[n - 1];
+  }
+  if (op == "resize")
+  {
+    if (v.first_touch)
+    {
+      parallel::first_touch_vector<int> fresh;
+      parallel::resize(*v.pool, fresh, n, 100, v.grain);
+      return fresh[n - 1];
+    }
+    int_vector fresh;
+    if (v.pool) parallel::resize(*v.pool, fresh, n, 100, v.grain);
+    else fresh.resize(n, 100);
+    return fresh[n - 1];
+  }
+  if (op == "for_each_index")
+  {
+    if (v.pool) parallel::for_each_index(*v.pool, a, [](std::size_t i, int& x) { x = int(i); }, v.grain);
+    else for (std::size_t i = 0; i < n; ++i) a[i] = int(i);
+    return a[n - 1];
+  }
+  if (op == "equal")
+    return v.pool ? parallel::equal(*v.pool, a, b, v.grain) : simd::equal(a, b);
+  if (op == "less")
+    return v.pool ? parallel::less(*v.pool, a, b, v.grain) : simd::less(a, b);
+  // sum
+  return v.pool ? parallel::sum(*v.pool, a, v.grain) : simd::sum(a);
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  // pools are built once, thread start-up is not what is measured
+  std::vector<std::unique_ptr<parallel::work_stealing_pool>> pools;
+  std::vector<std::unique_ptr<parallel::work_stealing_pool>> pinned_pools;
+  for (unsigned threads : opt.thread_counts())
+  {
+    pools.push_back(std::make_unique<parallel::work_stealing_pool>(threads));
+    pinned_pools.push_back(std::make_unique<parallel::work_stealing_pool>(threads, true));
+  }
+
+  for (std::size_t n : opt.sizes())
+  {
+    if (n < 100000) continue;
+    for (const char* op : {"fill", "resize", "for_each_index", "equal", "less", "sum"})
+    {
+      const std::string which = op;
+      std::vector<variant> variants = {{"serial", nullptr, 0, false}};
+      for (std::size_t k = 0; k < pools.size(); ++k)
+      {
+        const auto& pool = pools[k];
+        std::string t = "pool_t" + std::to_string(pool->size());
+        variants.push_back({t, pool.get(), parallel::default_grain, false});
+        if (which == "resize") variants.push_back({"first_touch_t" + std::to_string(pool->size()), pinned_pools[k].get(),
+                                                   parallel::default_grain, true});
+        if (pool == pools.back() && (which == "sum" || which == "fill"))
+          for (std::size_t grain : {std::size_t(1) << 10, std::size_t(1) << 14, std::size_t(1) << 18})
+            variants.push_back({t + "_g" + std::to_string(grain >> 10) + "k", pool.get(), grain, false});
+      }
+
+      double serial_ns = 0;
+      for (const variant& v : variants)
+      {
+        std::string case_name = std::string("parallel/") + op + "/int/" + v.name;
+        if (!opt.selected(case_name)) continue;
+
+        int_vector a (n);
+        std::iota(a.begin(), a.end(), 0);
+        int_vector b = a;
+        if (which == "less") b[n - 1] += 1;
+
+        bench::measurement m;
+        m.suite = "parallel";
+        m.op = op;
+        m.type = "int";
+        m.variant = v.name;
+        m.n = n;
+        m.items = n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          p.start();
+          std::int64_t r = run_op(which, v, a, b, n);
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        m.extra.push_back({"threads", double(v.pool ? v.pool->size() : 1)});
+        if (v.pool) m.extra.push_back({"grain", double(v.grain)});
+        if (!v.pool) serial_ns = m.best.ns;
+        else if (serial_ns > 0) m.extra.push_back({"speedup", serial_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+}
+
+bench::registration reg("parallel", &run);
+
+} // namespace
@@ -0,0 +1,139 @@
+//
+//  bench_persistent.cpp
+//  vectors_benchmark
+//
+// What?
+// Keeping a snapshot of a vector of n ints before every small change: the std::vector way
+// (snapshot = state, a deep copy into a kept vector) against persistent_vector (an O(1) copy, then
+// path copying on the change)
+// - set_1       : snapshot, then one element overwritten
+// - set_16      : snapshot, then a run of 16 neighbouring elements overwritten; persistent_transient
+//                 does them as one batch
+// - push_back   : snapshot, then one element appended
+// - scan        : sum of every element, what reading a persistent_vector costs (no snapshots)
+//
+// How?
+// One item is one snapshot plus its change (for scan, one element read). Each sample makes 64
+// snapshots; the previous one is dropped when the next is taken, as a reader holding the latest
+// state would. speedup is std_vector time / variant time: the std_vector copy grows with n, the
+// persistent_vector change stays at a few node copies.
+
+#include "bench.hpp"
+#include "persistent_vector.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t requests = 64;
+
+// positions of the changes, the same for every variant
+std::vector<std::size_t> positions(std::size_t n, std::size_t count) {
+  std::vector<std::size_t> out(count);
+  std::uint64_t x = 0x9e3779b97f4a7c15ull;
+  for (std::size_t& p : out)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    p = std::size_t(x % n);
+  }
+  return out;
+}
+
+std::size_t changes_per_request(const std::string& op) { return op == "set_16" ? 16 : 1; }
+
+// change k of a request starting at position p
+std::size_t target(std::size_t p, std::size_t k, std::size_t n) { return (p + k) % n; }
+
+std::int64_t run_std(const std::string& op, std::vector<int>& state, const std::vector<std::size_t>& at, std::size_t n) {
+  if (op == "scan")
+  {
+    std::int64_t s = 0;
+    for (int x : state) s += x;
+    return s;
+  }
+  std::vector<int> snapshot;
+  for (std::size_t r = 0; r < requests; ++r)
+  {
+    snapshot = state;
+    if (op == "push_back") state.push_back(int(r));
+    else for (std::size_t k = 0; k < changes_per_request(op); ++k) state[target(at[r], k, n)] = int(r);
+  }
+  return std::int64_t(snapshot.size()) + snapshot[at[0]];
+}
+
+std::int64_t run_persistent(const std::string& op, persistent_vector<int>& state, const std::vector<std::size_t>& at,
+                            std::size_t n, bool batch) {
+  if (op == "scan")
+  {
+    std::int64_t s = 0;
+    for (int x : state) s += x;
+    return s;
+  }
+  persistent_vector<int> snapshot;
+  for (std::size_t r = 0; r < requests; ++r)
+  {
+    snapshot = state;
+    if (op == "push_back") state.push_back(int(r));
+    else if (batch)
+    {
+      transient_vector<int> t = std::move(state).transient();
+      for (std::size_t k = 0; k < changes_per_request(op); ++k) t[target(at[r], k, n)] = int(r);
+      state = t.persistent();
+    }
+    else for (std::size_t k = 0; k < changes_per_request(op); ++k) state.set(target(at[r], k, n), int(r));
+  }
+  return std::int64_t(snapshot.size()) + snapshot[at[0]];
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  for (std::size_t n : opt.sizes())
+  {
+    for (const char* op : {"set_1", "set_16", "push_back", "scan"})
+    {
+      const std::string which = op;
+      const std::vector<std::size_t> at = positions(n, requests);
+      double std_ns = 0;
+      for (const char* variant : {"std_vector", "persistent_vector", "persistent_transient"})
+      {
+        const std::string kind = variant;
+        if (kind == "persistent_transient" && which != "set_16") continue;
+        std::string case_name = std::string("persistent/") + op + "/int/" + variant;
+        if (!opt.selected(case_name)) continue;
+
+        bench::measurement m;
+        m.suite = "persistent";
+        m.op = op;
+        m.type = "int";
+        m.variant = variant;
+        m.n = n;
+        m.items = which == "scan" ? n : requests;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          // a fresh state every sample, so push_back starts from n elements each time
+          std::vector<int> std_state;
+          persistent_vector<int> state;
+          for (std::size_t i = 0; i < n; ++i)
+          {
+            if (kind == "std_vector") std_state.push_back(int(i));
+            else state.push_back(int(i));
+          }
+          p.start();
+          std::int64_t r = kind == "std_vector" ? run_std(which, std_state, at, n)
+                                                : run_persistent(which, state, at, n, kind == "persistent_transient");
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        if (kind == "std_vector") std_ns = m.best.ns;
+        else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+}
+
+bench::registration reg("persistent", &run);
+
+} // namespace
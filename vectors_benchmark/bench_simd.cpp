@@ -0,0 +1,195 @@
+//
+//  bench_simd.cpp
+//  vectors_benchmark
+//
+// What?
+// The bulk loops of main.cpp on large std::vector<int>, with each kernel implementation of simd_kernels.hpp
+// - sum    : the pop_back accumulate loops
+// - reverse: the operator[] swap loop
+// - equal  : operator== on two equal vectors (full scan)
+// - less   : operator< on vectors differing only in the last element (full scan)
+// - fill   : assign(n, value)
+// - find   : first index of a value that is only in the last element
+//
+// How?
+// Variants are "std" (the standard algorithm / operator the demo uses) and every isa the CPU supports.
+// Before timing, each isa is checked against the scalar kernel and the std result on the same input;
+// any difference aborts the run (compress, unpack and crc32c are only verified; bench_batch_erase.cpp,
+// bench_compressed.cpp and bench_io.cpp time them).
+// speedup is std time / variant time.
+
+#include "bench.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<int> make_input(std::size_t n) {
+  std::vector<int> v(n);
+  // mixed signs and large magnitudes, so a 32 bit accumulator would overflow
+  for (std::size_t i = 0; i < n; ++i) v[i] = int((i * 2654435761u) ^ (i << 7));
+  return v;
+}
+
+void check(bool ok, const char* op, simd::isa i, std::size_t n) {
+  if (ok) return;
+  std::fprintf(stderr, "simd: %s (%s) differs from the reference for n=%zu\n", op, simd::isa_name(i), n);
+  std::abort();
+}
+
+void verify(simd::isa i, std::size_t n) {
+  const simd::kernels& k = simd::kernels_for(i);
+  const simd::kernels& ref = simd::kernels_for(simd::isa::scalar);
+  // a few unaligned starts and odd lengths around n, so the vector loops and the tails are both hit
+  for (std::size_t offset : {std::size_t(0), std::size_t(1), std::size_t(3)})
+  for (std::size_t len : {n, n - 1, n - 7})
+  {
+    std::vector<int> a = make_input(len + offset);
+    const int* p = a.data() + offset;
+    std::size_t m = len;
+
+    std::int64_t expected_sum = std::accumulate(p, p + m, std::int64_t(0));
+    check(k.sum(p, m) == expected_sum && ref.sum(p, m) == expected_sum, "sum", i, m);
+
+    std::vector<int> r(p, p + m), s(p, p + m);
+    k.reverse(r.data(), m);
+    std::reverse(s.begin(), s.end());
+    check(r == s, "reverse", i, m);
+
+    std::vector<int> b(p, p + m);
+    check(k.mismatch(p, b.data(), m) == m, "mismatch", i, m);
+    for (std::size_t at : {std::size_t(0), m / 2, m - 1})
+    {
+      b[at] ^= 1;
+      check(k.mismatch(p, b.data(), m) == at, "mismatch", i, m);
+      b[at] ^= 1;
+    }
+
+    std::vector<int> f(m + 2, -1);
+    k.fill(f.data() + 1, m, 42);
+    check(f.front() == -1 && f.back() == -1 && std::count(f.begin(), f.end(), 42) == std::ptrdiff_t(m), "fill", i, m);
+
+    check(k.find(p, m, p[m - 1]) == std::size_t(std::find(p, p + m, p[m - 1]) - p), "find", i, m);
+    check(k.find(p, m, 7) == std::size_t(std::find(p, p + m, 7) - p), "find", i, m);
+
+    std::vector<std::uint64_t> remove ((m + 63) / 64);
+    std::vector<int> kept;
+    for (std::size_t j = 0; j < m; ++j)
+    {
+      if ((j * 2654435761u) % 3 == 0) remove[j / 64] |= std::uint64_t(1) << (j % 64);
+      else kept.push_back(p[j]);
+    }
+    std::vector<int> c(p, p + m);
+    c.resize(k.compress(c.data(), m, remove.data(), c.data()));
+    check(c == kept, "compress", i, m);
+  }
+
+  // every bit width, on words with all bits in use
+  std::vector<std::uint32_t> packed(4 * 32);
+  for (std::size_t j = 0; j < packed.size(); ++j) packed[j] = std::uint32_t(j + 1) * 2654435761u ^ std::uint32_t(j << 27);
+  for (unsigned bits = 0; bits <= 32; ++bits)
+  {
+    std::vector<std::uint32_t> got(128), want(128);
+    k.unpack_for(packed.data(), bits, 0x80000000u, got.data());
+    ref.unpack_for(packed.data(), bits, 0x80000000u, want.data());
+    check(got == want, "unpack_for", i, bits);
+    k.unpack_delta(packed.data(), bits, 7, 0xfffffff0u, got.data());
+    ref.unpack_delta(packed.data(), bits, 7, 0xfffffff0u, want.data());
+    check(got == want, "unpack_delta", i, bits);
+  }
+
+  // the standard check value, then odd lengths and a split computation
+  check(k.crc32c(0, "123456789", 9) == 0xE3069283u, "crc32c", i, 9);
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(packed.data());
+  for (std::size_t len : {std::size_t(0), std::size_t(1), std::size_t(7), std::size_t(100), std::size_t(511)})
+  {
+    check(k.crc32c(0, bytes, len) == ref.crc32c(0, bytes, len), "crc32c", i, len);
+    check(k.crc32c(k.crc32c(0, bytes, len / 3), bytes + len / 3, len - len / 3) == ref.crc32c(0, bytes, len), "crc32c", i, len);
+  }
+}
+
+// one timed iteration of op on (a, b), with kernels k or the std version when k is null
+std::int64_t run_op(const std::string& op, const simd::kernels* k, std::vector<int>& a, std::vector<int>& b) {
+  const std::size_t n = a.size();
+  if (op == "sum")
+    return k ? k->sum(a.data(), n) : std::accumulate(a.begin(), a.end(), std::int64_t(0));
+  if (op == "reverse")
+  {
+    if (k) k->reverse(a.data(), n);
+    else std::reverse(a.begin(), a.end());
+    return a[0];
+  }
+  if (op == "equal")
+    return k ? k->mismatch(a.data(), b.data(), n) == n : a == b;
+  if (op == "less")
+  {
+    if (!k) return a < b;
+    std::size_t i = k->mismatch(a.data(), b.data(), n);
+    return i < n && a[i] < b[i];
+  }
+  if (op == "fill")
+  {
+    if (k) k->fill(a.data(), n, 100);
+    else a.assign(n, 100);
+    return a[n - 1];
+  }
+  // find
+  return std::int64_t(k ? k->find(a.data(), n, a[n - 1]) : std::size_t(std::find(a.begin(), a.end(), a[n - 1]) - a.begin()));
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  const simd::isa isas[] = {simd::isa::scalar, simd::isa::sse2, simd::isa::avx2, simd::isa::avx512};
+  const char* ops[] = {"sum", "reverse", "equal", "less", "fill", "find"};
+
+  for (std::size_t n : opt.sizes())
+  {
+    if (n < 1000) continue;
+    for (simd::isa i : isas)
+      if (simd::supported(i)) verify(i, n);
+
+    for (const char* op : ops)
+    {
+      double std_ns = 0;
+      for (int variant = -1; variant < int(sizeof(isas) / sizeof(isas[0])); ++variant)
+      {
+        const simd::kernels* k = variant < 0 ? nullptr : &simd::kernels_for(isas[variant]);
+        if (k && !simd::supported(isas[variant])) continue;
+        const char* name = k ? simd::isa_name(k->id) : "std";
+        std::string case_name = std::string("simd/") + op + "/int/" + name;
+        if (!opt.selected(case_name)) continue;
+
+        std::vector<int> a = make_input(n);
+        std::vector<int> b = a;
+        if (std::string(op) == "less") b[n - 1] += 1;
+        if (std::string(op) == "find") a[n - 1] = -7;   // rarely elsewhere in the input, so the search scans to the end
+
+        bench::measurement m;
+        m.suite = "simd";
+        m.op = op;
+        m.type = "int";
+        m.variant = name;
+        m.n = n;
+        m.items = n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          p.start();
+          std::int64_t r = run_op(op, k, a, b);
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        if (!k) std_ns = m.best.ns;
+        else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+}
+
+bench::registration reg("simd", &run);
+
+} // namespace
@@ -0,0 +1,164 @@
+//
+//  bench_small_vector.cpp
+//  vectors_benchmark
+//
+// What?
+// std::vector<int> against small_vector<int, 16> on the short-lived, 3 to 10 element vectors of main.cpp
+// One item is one whole demo: construct, modify, destroy
+//
+// How?
+// Each demo is written once as a template and run on both containers.
+// The allocs_per_op column shows the malloc-free behaviour (0 for small_vector until it spills),
+// speedup is std::vector time / small_vector time for the same demo.
+
+#include "bench.hpp"
+#include "small_vector.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+template <class Vec, std::size_t K>
+int demo_build() {
+  Vec v;
+  for (std::size_t i = 0; i < K; ++i) v.push_back(int(i));
+  return v.back();
+}
+
+// vec_front / vec_clear / vec_pop_back
+template <class Vec>
+int demo_pop_back() {
+  Vec v;
+  v.push_back(100);
+  v.push_back(200);
+  v.push_back(300);
+  int sum = 0;
+  while (!v.empty())
+  {
+    sum += v.back();
+    v.pop_back();
+  }
+  return sum;
+}
+
+template <class Vec>
+int demo_emplace() {
+  Vec v = {10,20,30};
+  auto it = v.emplace(v.begin()+1, 100);
+  v.emplace(it, 200);
+  v.emplace(v.end(), 300);
+  return v[1];
+}
+
+template <class Vec>
+int demo_insert() {
+  Vec v (3,100);
+  auto it = v.insert(v.begin(), 200);
+  v.insert(it, 2, 300);
+  Vec v2 (2,400);
+  v.insert(v.begin()+2, v2.begin(), v2.end());
+  int data_array [] = { 501,502,503 };
+  v.insert(v.begin(), data_array, data_array+3);
+  return v[4];
+}
+
+template <class Vec>
+int demo_erase() {
+  Vec v;
+  for (int i=1; i<=10; i++) v.push_back(i);
+  v.erase(v.begin()+5);
+  v.erase(v.begin(), v.begin()+3);
+  return v.front();
+}
+
+template <class Vec>
+int demo_resize() {
+  Vec v;
+  for (int i=1; i<10; i++) v.push_back(i);
+  v.resize(5);
+  v.resize(8,100);
+  v.resize(12);
+  return v[7];
+}
+
+template <class Vec>
+int demo_swap() {
+  Vec a (3,100);
+  Vec b (5,200);
+  a.swap(b);
+  return a[0] + int(b.size());
+}
+
+template <class Vec>
+int demo_relational() {
+  Vec a (3,100);
+  Vec b (2,200);
+  return (a==b) + (a!=b) + (a<b) + (a>b) + (a<=b) + (a>=b);
+}
+
+using std_vec = std::vector<int>;
+using small_vec = small_vector<int, 16>;
+
+struct demo {
+  const char* name;
+  std::size_t k;   // elements pushed, for build
+  int (*std_fn)();
+  int (*small_fn)();
+};
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  const demo demos[] = {
+    {"build", 3, &demo_build<std_vec, 3>, &demo_build<small_vec, 3>},
+    {"build", 10, &demo_build<std_vec, 10>, &demo_build<small_vec, 10>},
+    {"build", 16, &demo_build<std_vec, 16>, &demo_build<small_vec, 16>},
+    {"build", 64, &demo_build<std_vec, 64>, &demo_build<small_vec, 64>},
+    {"pop_back", 0, &demo_pop_back<std_vec>, &demo_pop_back<small_vec>},
+    {"emplace", 0, &demo_emplace<std_vec>, &demo_emplace<small_vec>},
+    {"insert", 0, &demo_insert<std_vec>, &demo_insert<small_vec>},
+    {"erase", 0, &demo_erase<std_vec>, &demo_erase<small_vec>},
+    {"resize", 0, &demo_resize<std_vec>, &demo_resize<small_vec>},
+    {"swap", 0, &demo_swap<std_vec>, &demo_swap<small_vec>},
+    {"relational", 0, &demo_relational<std_vec>, &demo_relational<small_vec>},
+  };
+  const std::size_t items = 100000;
+
+  for (const demo& d : demos)
+  {
+    double std_ns = 0;
+    for (int variant = 0; variant < 2; ++variant)
+    {
+      const char* name = variant == 0 ? "std_vector" : "small_vector16";
+      std::string case_name = std::string("small_vector/") + d.name + "/int/" + name;
+      if (!opt.selected(case_name)) continue;
+      int (*fn)() = variant == 0 ? d.std_fn : d.small_fn;
+
+      bench::measurement m;
+      m.suite = "small_vector";
+      m.op = d.name;
+      m.type = "int";
+      m.variant = name;
+      m.n = d.k;
+      m.items = items;
+      m.best = bench::run_case(opt, [&](bench::probe& p) {
+        int sink = 0;
+        p.start();
+        for (std::size_t i = 0; i < items; ++i)
+        {
+          sink += fn();
+          bench::clobber_memory();
+        }
+        p.stop();
+        bench::do_not_optimize(sink);
+      });
+      m.extra.push_back({"allocs_per_op", double(m.best.allocations) / double(items)});
+      if (variant == 0) std_ns = m.best.ns;
+      else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+      rep.add(std::move(m));
+    }
+  }
+}
+
+bench::registration reg("small_vector", &run);
+
+} // namespace
@@ -0,0 +1,206 @@
+//
+//  bench_soa.cpp
+//  vectors_benchmark
+//
+// What?
+// A particle record (position, velocity, mass, id: 64 bytes) kept as std::vector<particle> (array of
+// structs) against soa_vector<double x 7, int> (one column per field)
+// - scan_one   : sum of x, one field of eight
+// - scan_two   : sum of x * vx, two fields
+// - sum_ids    : sum of the int id field; "soa_vector_simd" hands the column to simd::sum
+// - update     : x += vx for every record (one field read, one written)
+// - append     : push_back of n full records into an empty vector
+//
+// How?
+// One item is one record. speedup is std_vector time / variant time. The double sums use four
+// accumulators in both layouts. In cache the columns win because they vectorize; out of cache they win
+// more because they load only the fields in use. append is where the columns cost something: eight
+// streams to write instead of one.
+
+#include "bench.hpp"
+#include "simd_kernels.hpp"
+#include "soa_vector.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct particle {
+  double x, y, z;
+  double vx, vy, vz;
+  double mass;
+  int id;
+};
+
+using particles_soa = soa_vector<double, double, double, double, double, double, double, int>;
+enum field { X, Y, Z, VX, VY, VZ, MASS, ID };
+
+particle make_particle(std::size_t i) {
+  double d = double(i);
+  return {d, d + 1, d + 2, 0.5, 0.25, 0.125, 1.0 + d * 1e-6, int(i)};
+}
+
+void fill(std::vector<particle>& v, std::size_t n) {
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) v.push_back(make_particle(i));
+}
+
+void fill(particles_soa& v, std::size_t n) {
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    particle p = make_particle(i);
+    v.emplace_back(p.x, p.y, p.z, p.vx, p.vy, p.vz, p.mass, p.id);
+  }
+}
+
+// four independent sums, so the scans wait on memory rather than on the latency of one add chain
+template <class Term>
+double sum4(std::size_t n, Term term) {
+  double r[4] = {0, 0, 0, 0};
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    for (std::size_t k = 0; k < 4; ++k) r[k] += term(i + k);
+  for (; i < n; ++i) r[0] += term(i);
+  return (r[0] + r[1]) + (r[2] + r[3]);
+}
+
+double run_op(const std::string& op, std::vector<particle>& v, std::size_t n) {
+  double r = 0;
+  const particle* p = v.data();
+  if (op == "scan_one") r = sum4(n, [p](std::size_t i) { return p[i].x; });
+  else if (op == "scan_two") r = sum4(n, [p](std::size_t i) { return p[i].x * p[i].vx; });
+  else if (op == "sum_ids") { std::int64_t s = 0; for (const particle& p : v) s += p.id; r = double(s); }
+  else if (op == "update") { for (particle& p : v) p.x += p.vx; r = v[n / 2].x; }
+  else
+  {
+    std::vector<particle> out;
+    for (std::size_t i = 0; i < n; ++i) out.push_back(make_particle(i));
+    r = out.back().x;
+  }
+  return r;
+}
+
+double run_op(const std::string& op, particles_soa& v, std::size_t n, bool simd) {
+  double r = 0;
+  const double* x = v.data<X>();
+  const double* vx = v.data<VX>();
+  if (op == "scan_one") r = sum4(n, [x](std::size_t i) { return x[i]; });
+  else if (op == "scan_two") r = sum4(n, [x, vx](std::size_t i) { return x[i] * vx[i]; });
+  else if (op == "sum_ids")
+  {
+    if (simd) r = double(simd::sum(v.data<ID>(), n));
+    else { std::int64_t s = 0; for (int id : v.column<ID>()) s += id; r = double(s); }
+  }
+  else if (op == "update")
+  {
+    double* out = v.data<X>();
+    for (std::size_t i = 0; i < n; ++i) out[i] += vx[i];
+    r = out[n / 2];
+  }
+  else
+  {
+    particles_soa out;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      particle p = make_particle(i);
+      out.emplace_back(p.x, p.y, p.z, p.vx, p.vy, p.vz, p.mass, p.id);
+    }
+    r = out.get<X>(n - 1);
+  }
+  return r;
+}
+
+// a field with a destructor; live is how many exist
+struct counted {
+  static long live;
+  int value;
+  counted(int v = 0) : value(v) { ++live; }
+  counted(const counted& other) noexcept : value(other.value) { ++live; }
+  counted& operator=(const counted&) noexcept = default;
+  ~counted() { --live; }
+};
+long counted::live = 0;
+
+void check_lifetimes() {
+  {
+    soa_vector<counted, std::string> v;
+    auto expect = [&v](const char* after) {
+      if (counted::live != long(v.size()))
+      {
+        std::fprintf(stderr, "soa: %ld fields alive for %zu records after %s\n", counted::live, v.size(), after);
+        std::abort();
+      }
+    };
+    for (int i = 0; i < 100; ++i) v.emplace_back(counted(i), std::string(40, char('a' + i % 26)));
+    expect("emplace_back");
+    v.pop_back();
+    v.pop_back();
+    expect("pop_back");
+    v.erase(v.begin() + 10, v.begin() + 30);
+    expect("erase");
+    v.insert(v.begin() + 5, 3, {counted(7), std::string(40, 'z')});
+    expect("insert");
+    v.resize(20);
+    expect("resize");
+    v.clear();
+    expect("clear");
+  }
+  if (counted::live != 0)
+  {
+    std::fprintf(stderr, "soa: %ld fields alive after destruction\n", counted::live);
+    std::abort();
+  }
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  check_lifetimes();
+  for (std::size_t n : opt.sizes())
+  {
+    for (const char* op : {"scan_one", "scan_two", "sum_ids", "update", "append"})
+    {
+      const std::string which = op;
+      double std_ns = 0;
+      for (const char* variant : {"std_vector", "soa_vector", "soa_vector_simd"})
+      {
+        const std::string kind = variant;
+        if (kind == "soa_vector_simd" && which != "sum_ids") continue;
+        std::string case_name = std::string("soa/") + op + "/particle/" + variant;
+        if (!opt.selected(case_name)) continue;
+
+        // the scanned vectors are built once per case, outside the timed region
+        std::vector<particle> aos;
+        particles_soa soa;
+        if (which != "append")
+        {
+          if (kind == "std_vector") fill(aos, n);
+          else fill(soa, n);
+        }
+
+        bench::measurement m;
+        m.suite = "soa";
+        m.op = op;
+        m.type = "particle";
+        m.variant = variant;
+        m.n = n;
+        m.items = n;
+        m.best = bench::run_case(opt, [&](bench::probe& p) {
+          p.start();
+          double r = kind == "std_vector" ? run_op(which, aos, n) : run_op(which, soa, n, kind == "soa_vector_simd");
+          p.stop();
+          bench::do_not_optimize(r);
+        });
+        if (kind == "std_vector") std_ns = m.best.ns;
+        else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+        rep.add(std::move(m));
+      }
+    }
+  }
+}
+
+bench::registration reg("soa", &run);
+
+} // namespace
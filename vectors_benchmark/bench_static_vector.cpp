@@ -0,0 +1,394 @@
+//
+//  bench_static_vector.cpp
+//  vectors_benchmark
+//
+// What?
+// 1. Every section of main.cpp redone on static_vector<int, N> inside a constexpr function and
+//    checked with static_assert: if this file compiles, static_vector gives the demo's results at
+//    compile time
+// 2. The cost, paid at startup, of building tables that are known at compile time
+//    - demo_tables : the small vectors of main.cpp (int_array, vec_cbegin_cend, vec_at, vec_back ...)
+//    - crc32_table : a 256-entry CRC-32 lookup table
+//    Variants: std_vector and static_vector_runtime build the tables when the sample runs;
+//    static_vector_constexpr reads tables the compiler built (static constexpr, read-only data)
+//
+// How?
+// Each sample builds the tables (nothing to build for constexpr) and reads every entry once, so the
+// difference between the variants is what construction costs. One item is one table entry.
+// speedup is std_vector time / variant time. The runtime builds start from a volatile value so
+// the compiler cannot fold them into constants.
+
+#include "bench.hpp"
+#include "static_vector.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 1. main.cpp, section by section
+
+constexpr bool assign_section() {
+  static_vector<int, 8> first_assign;
+  static_vector<int, 8> second_assign;
+  static_vector<int, 8> third_assign;
+  first_assign.assign(7, 100);
+  second_assign.assign(first_assign.begin() + 1, first_assign.end() - 1);
+  int int_array[] = {1776, 7, 4};
+  third_assign.assign(int_array, int_array + 3);
+  return first_assign.size() == 7 && second_assign.size() == 5 && third_assign == static_vector<int, 8>{1776, 7, 4};
+}
+static_assert(assign_section(), "assign");
+
+constexpr bool at_section() {
+  static_vector<int, 10> vec_at (10);
+  for (unsigned i = 0; i < vec_at.size(); i++) vec_at.at(i) = int(i);
+  return vec_at == static_vector<int, 10>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+}
+static_assert(at_section(), "at");
+
+constexpr bool back_section() {
+  static_vector<int, 16> vec_back;
+  vec_back.push_back(10);
+  while (vec_back.back() != 0) vec_back.push_back(vec_back.back() - 1);
+  return vec_back == static_vector<int, 16>{10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+}
+static_assert(back_section(), "back");
+
+constexpr bool begin_end_section() {
+  static_vector<int, 5> vec_begin;
+  for (int i = 1; i <= 5; i++) vec_begin.push_back(i);
+  int expected = 1;
+  for (auto it = vec_begin.begin(); it != vec_begin.end(); ++it)
+    if (*it != expected++) return false;
+  return expected == 6;
+}
+static_assert(begin_end_section(), "begin/end");
+
+constexpr bool front_section() {
+  static_vector<int, 2> vec_front;
+  vec_front.push_back(78);
+  vec_front.push_back(16);
+  vec_front.front() -= vec_front.back();
+  return vec_front.front() == 62;
+}
+static_assert(front_section(), "front");
+
+constexpr bool capacity_section() {
+  static_vector<int, 128> vec_capacity;
+  for (int i = 0; i < 100; i++) vec_capacity.push_back(i);
+  return vec_capacity.size() == 100 && vec_capacity.capacity() == 128 && vec_capacity.max_size() == 128;
+}
+static_assert(capacity_section(), "capacity");
+
+constexpr bool cbegin_cend_section() {
+  static_vector<int, 5> vec_cbegin_cend = {10, 20, 30, 40, 50};
+  int sum = 0;
+  for (auto it = vec_cbegin_cend.cbegin(); it != vec_cbegin_cend.cend(); ++it) sum += *it;
+  return sum == 150;
+}
+static_assert(cbegin_cend_section(), "cbegin/cend");
+
+constexpr bool clear_section() {
+  static_vector<int, 4> vec_clear;
+  vec_clear.push_back(100);
+  vec_clear.push_back(200);
+  vec_clear.push_back(300);
+  vec_clear.clear();
+  vec_clear.push_back(1101);
+  vec_clear.push_back(2202);
+  return vec_clear == static_vector<int, 4>{1101, 2202} && vec_clear.data()[2] == 0;
+}
+static_assert(clear_section(), "clear");
+
+constexpr bool crbegin_crend_section() {
+  static_vector<int, 5> vec_crbegin_crend = {1, 2, 3, 4, 5};
+  int expected = 5;
+  for (auto rit = vec_crbegin_crend.crbegin(); rit != vec_crbegin_crend.crend(); ++rit)
+    if (*rit != expected--) return false;
+  return expected == 0;
+}
+static_assert(crbegin_crend_section(), "crbegin/crend");
+
+constexpr bool data_section() {
+  static_vector<int, 5> vec_data (5);
+  int* p = vec_data.data();
+  *p = 10;
+  ++p;
+  *p = 20;
+  p[2] = 100;
+  return vec_data == static_vector<int, 5>{10, 20, 0, 100, 0};
+}
+static_assert(data_section(), "data");
+
+constexpr bool emplace_section() {
+  static_vector<int, 6> vec_emplace = {10, 20, 30};
+  auto vec_emplace_it = vec_emplace.emplace(vec_emplace.begin() + 1, 100);
+  vec_emplace.emplace(vec_emplace_it, 200);
+  vec_emplace.emplace(vec_emplace.end(), 300);
+  return vec_emplace == static_vector<int, 6>{10, 200, 100, 20, 30, 300};
+}
+static_assert(emplace_section(), "emplace");
+
+constexpr bool emplace_back_section() {
+  static_vector<int, 5> vec_emplace_back = {10, 20, 30};
+  vec_emplace_back.emplace_back(100);
+  vec_emplace_back.emplace_back(200);
+  return vec_emplace_back == static_vector<int, 5>{10, 20, 30, 100, 200};
+}
+static_assert(emplace_back_section(), "emplace_back");
+
+constexpr bool empty_section() {
+  static_vector<int, 10> vec_empty;
+  int sum = 0;
+  for (int i = 1; i <= 10; i++) vec_empty.push_back(i);
+  while (!vec_empty.empty())
+  {
+    sum += vec_empty.back();
+    vec_empty.pop_back();
+  }
+  return sum == 55;
+}
+static_assert(empty_section(), "empty");
+
+constexpr bool erase_section() {
+  static_vector<int, 10> vec_erase;
+  for (int i = 1; i <= 10; i++) vec_erase.push_back(i);
+  vec_erase.erase(vec_erase.begin() + 5);
+  vec_erase.erase(vec_erase.begin(), vec_erase.begin() + 3);
+  return vec_erase == static_vector<int, 10>{4, 5, 7, 8, 9, 10};
+}
+static_assert(erase_section(), "erase");
+
+constexpr bool insert_section() {
+  static_vector<int, 12> vec_insert (3, 100);
+  auto vec_insert_it = vec_insert.begin();
+  vec_insert_it = vec_insert.insert(vec_insert_it, 200);
+  vec_insert.insert(vec_insert_it, 2, 300);
+  vec_insert_it = vec_insert.begin();
+  static_vector<int, 2> vec_insert_2 (2, 400);
+  vec_insert.insert(vec_insert_it + 2, vec_insert_2.begin(), vec_insert_2.end());
+  int data_array[] = {501, 502, 503};
+  vec_insert.insert(vec_insert.begin(), data_array, data_array + 3);
+  return vec_insert == static_vector<int, 12>{501, 502, 503, 300, 300, 400, 400, 200, 100, 100, 100};
+}
+static_assert(insert_section(), "insert");
+
+constexpr bool assignment_section() {
+  static_vector<int, 5> vec_1_equal_op (3, 0);
+  static_vector<int, 5> vec_2_equal_op (5, 0);
+  vec_2_equal_op = vec_1_equal_op;
+  vec_1_equal_op = static_vector<int, 5>();
+  return vec_1_equal_op.size() == 0 && vec_2_equal_op.size() == 3;
+}
+static_assert(assignment_section(), "operator=");
+
+constexpr bool subscript_section() {
+  static_vector<int, 10> vec_at_op (10);
+  auto sz = vec_at_op.size();
+  for (unsigned i = 0; i < sz; i++) vec_at_op[i] = int(i);
+  for (unsigned i = 0; i < sz / 2; i++)
+  {
+    int temp = vec_at_op[sz - 1 - i];
+    vec_at_op[sz - 1 - i] = vec_at_op[i];
+    vec_at_op[i] = temp;
+  }
+  return vec_at_op == static_vector<int, 10>{9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+}
+static_assert(subscript_section(), "operator[]");
+
+constexpr bool pop_back_section() {
+  static_vector<int, 3> vec_pop_back;
+  int vec_pop_back_sum = 0;
+  vec_pop_back.push_back(100);
+  vec_pop_back.push_back(200);
+  vec_pop_back.push_back(300);
+  while (!vec_pop_back.empty())
+  {
+    vec_pop_back_sum += vec_pop_back.back();
+    vec_pop_back.pop_back();
+  }
+  return vec_pop_back_sum == 600;
+}
+static_assert(pop_back_section(), "pop_back");
+
+constexpr bool push_back_section() {
+  static_vector<int, 1> vec_push_back;
+  int x = 420;
+  vec_push_back.push_back(x);
+  return vec_push_back.size() == 1;
+}
+static_assert(push_back_section(), "push_back");
+
+constexpr bool resize_section() {
+  static_vector<int, 12> vec_resize;
+  for (int i = 1; i < 10; i++) vec_resize.push_back(i);
+  vec_resize.resize(5);
+  vec_resize.resize(8, 100);
+  vec_resize.resize(12);
+  return vec_resize == static_vector<int, 12>{1, 2, 3, 4, 5, 100, 100, 100, 0, 0, 0, 0};
+}
+static_assert(resize_section(), "resize");
+
+constexpr bool shrink_to_fit_section() {
+  static_vector<int, 100> vec_shrink_to_fit (100);
+  vec_shrink_to_fit.resize(10);
+  vec_shrink_to_fit.shrink_to_fit();
+  return vec_shrink_to_fit.size() == 10 && vec_shrink_to_fit.capacity() == 100;
+}
+static_assert(shrink_to_fit_section(), "shrink_to_fit");
+
+constexpr bool size_section() {
+  static_vector<int, 20> vec_size;
+  bool ok = vec_size.size() == 0;
+  for (int i = 0; i < 10; i++) vec_size.push_back(i);
+  ok = ok && vec_size.size() == 10;
+  vec_size.insert(vec_size.end(), 10, 100);
+  ok = ok && vec_size.size() == 20;
+  vec_size.pop_back();
+  return ok && vec_size.size() == 19;
+}
+static_assert(size_section(), "size");
+
+constexpr bool relational_section() {
+  static_vector<int, 3> vec_1_relational_op (3, 100);
+  static_vector<int, 3> vec_2_relational_op (2, 200);
+  return !(vec_1_relational_op == vec_2_relational_op) && vec_1_relational_op != vec_2_relational_op &&
+         vec_1_relational_op < vec_2_relational_op && !(vec_1_relational_op > vec_2_relational_op) &&
+         vec_1_relational_op <= vec_2_relational_op && !(vec_1_relational_op >= vec_2_relational_op);
+}
+static_assert(relational_section(), "relational operators");
+
+constexpr bool swap_section() {
+  static_vector<int, 5> vec_1_swap_vec (3, 100);
+  static_vector<int, 5> vec_2_swap_vec (5, 200);
+  swap(vec_1_swap_vec, vec_2_swap_vec);
+  bool ok = vec_1_swap_vec == static_vector<int, 5>(5, 200) && vec_2_swap_vec == static_vector<int, 5>(3, 100);
+  vec_1_swap_vec.swap(vec_2_swap_vec);
+  return ok && vec_1_swap_vec == static_vector<int, 5>(3, 100) && vec_2_swap_vec == static_vector<int, 5>(5, 200);
+}
+static_assert(swap_section(), "swap");
+
+
+// 2. tables built at runtime or at compile time
+
+template <class Vec>
+struct demo_tables {
+  Vec int_array, cbegin_cend, at, back, emplace, erase;
+};
+
+// seed is 1; at runtime it comes from a volatile so nothing below can be folded
+template <class Vec>
+constexpr demo_tables<Vec> build_demo_tables(int seed) {
+  demo_tables<Vec> t;
+  t.int_array = {1776 * seed, 7 * seed, 4 * seed};
+  t.cbegin_cend = {10 * seed, 20 * seed, 30 * seed, 40 * seed, 50 * seed};
+  t.at.resize(10);
+  for (unsigned i = 0; i < t.at.size(); i++) t.at.at(i) = int(i) * seed;
+  t.back.push_back(10 * seed);
+  while (t.back.back() != 0) t.back.push_back(t.back.back() - seed);
+  t.emplace = {10 * seed, 20 * seed, 30 * seed};
+  auto it = t.emplace.emplace(t.emplace.begin() + 1, 100 * seed);
+  t.emplace.emplace(it, 200 * seed);
+  t.emplace.emplace(t.emplace.end(), 300 * seed);
+  for (int i = 1; i <= 10; i++) t.erase.push_back(i * seed);
+  t.erase.erase(t.erase.begin() + 5);
+  t.erase.erase(t.erase.begin(), t.erase.begin() + 3);
+  return t;
+}
+
+template <class Vec>
+std::int64_t read_demo_tables(const demo_tables<Vec>& t) {
+  std::int64_t sum = 0;
+  for (const Vec* v : {&t.int_array, &t.cbegin_cend, &t.at, &t.back, &t.emplace, &t.erase})
+    for (int x : *v) sum += x;
+  return sum;
+}
+
+constexpr std::size_t demo_table_entries = 3 + 5 + 10 + 11 + 6 + 6;
+
+template <class Vec>
+constexpr Vec build_crc32_table(std::uint32_t seed) {
+  Vec table (256);
+  for (std::uint32_t i = 0; i < 256; ++i)
+  {
+    std::uint32_t c = i * seed;
+    for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    table[i] = c;
+  }
+  return table;
+}
+
+using int_table = static_vector<int, 16>;
+using crc_table = static_vector<std::uint32_t, 256>;
+
+static constexpr demo_tables<int_table> constexpr_demo_tables = build_demo_tables<int_table>(1);
+static constexpr crc_table constexpr_crc32_table = build_crc32_table<crc_table>(1);
+static_assert(constexpr_crc32_table[1] == 0x77073096u && constexpr_crc32_table[255] == 0x2D02EF8Du, "CRC-32 table");
+
+volatile int g_seed = 1;
+
+template <class Vec>
+std::int64_t read_crc32_table(const Vec& t) {
+  std::int64_t sum = 0;
+  for (std::uint32_t x : t) sum += x;
+  return sum;
+}
+
+std::int64_t run_op(const std::string& op, const std::string& variant) {
+  const int seed = g_seed;
+  if (op == "demo_tables")
+  {
+    if (variant == "std_vector") return read_demo_tables(build_demo_tables<std::vector<int>>(seed));
+    if (variant == "static_vector_runtime") return read_demo_tables(build_demo_tables<int_table>(seed));
+    return read_demo_tables(constexpr_demo_tables);
+  }
+  if (variant == "std_vector") return read_crc32_table(build_crc32_table<std::vector<std::uint32_t>>(std::uint32_t(seed)));
+  if (variant == "static_vector_runtime") return read_crc32_table(build_crc32_table<crc_table>(std::uint32_t(seed)));
+  return read_crc32_table(constexpr_crc32_table);
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  for (const char* op : {"demo_tables", "crc32_table"})
+  {
+    const std::string which = op;
+    const std::size_t entries = which == "demo_tables" ? demo_table_entries : 256;
+    const char* type = which == "demo_tables" ? "int" : "uint32";
+    std::int64_t expected = run_op(which, "static_vector_constexpr");
+    double std_ns = 0;
+    for (const char* variant : {"std_vector", "static_vector_runtime", "static_vector_constexpr"})
+    {
+      std::string case_name = std::string("static_vector/") + op + '/' + type + '/' + variant;
+      if (!opt.selected(case_name)) continue;
+      if (run_op(which, variant) != expected)
+      {
+        std::fprintf(stderr, "static_vector: %s differs from the constexpr table\n", case_name.c_str());
+        std::abort();
+      }
+
+      bench::measurement m;
+      m.suite = "static_vector";
+      m.op = op;
+      m.type = type;
+      m.variant = variant;
+      m.n = entries;
+      m.items = entries;
+      m.best = bench::run_case(opt, [&](bench::probe& p) {
+        p.start();
+        std::int64_t r = run_op(which, variant);
+        p.stop();
+        bench::do_not_optimize(r);
+      });
+      if (std::string(variant) == "std_vector") std_ns = m.best.ns;
+      else if (std_ns > 0) m.extra.push_back({"speedup", std_ns / m.best.ns});
+      rep.add(std::move(m));
+    }
+  }
+}
+
+bench::registration reg("static_vector", &run);
+
+} // namespace
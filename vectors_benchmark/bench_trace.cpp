@@ -0,0 +1,93 @@
+//
+//  bench_trace.cpp
+//  vectors_benchmark
+//
+// What?
+// The capacity() and shrink_to_fit() sections of main.cpp at large sizes, counted with tracing.hpp
+// - push_back        : grow from empty by push_back (vec_capacity), every reallocation moves all elements
+// - reserve_push_back: the same after reserve(n), for comparison
+// - shrink_to_fit    : n elements, resize(n/10), shrink_to_fit() (vec_shrink_to_fit)
+//
+// How?
+// The elements are traced<int> and traced<pod64> in a std::vector with tracing_allocator, so the extra
+// columns show allocations, element copies (the appended values) and the moves that reallocation adds.
+
+#include "bench.hpp"
+#include "bench_types.hpp"
+#include "tracing.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+template <class T>
+using traced_vector = std::vector<traced<T>, tracing_allocator<traced<T>>>;
+
+template <class T>
+void scenario(const bench::options& opt, bench::reporter& rep, const char* op, std::size_t n) {
+  std::string case_name = std::string("trace/") + op + '/' + bench::type_name<T>::value + "/traced";
+  if (!opt.selected(case_name)) return;
+
+  trace_log& log = trace_log::instance();
+  log.record_events(false);
+  trace_counters counted;
+  std::string which = op;
+
+  bench::measurement m;
+  m.suite = "trace";
+  m.op = op;
+  m.type = bench::type_name<T>::value;
+  m.variant = "traced";
+  m.n = n;
+  m.items = which == "shrink_to_fit" ? n / 10 : n;
+  m.best = bench::run_case(opt, [&](bench::probe& p) {
+    traced_vector<T> v;
+    if (which == "shrink_to_fit")
+    {
+      v.resize(n);
+      v.resize(n / 10);
+    }
+    else if (which == "reserve_push_back")
+    {
+      v.reserve(n);
+    }
+    const traced<T> value = bench::make_value<T>(7);
+    log.clear();
+    p.start();
+    if (which == "shrink_to_fit") v.shrink_to_fit();
+    else for (std::size_t i = 0; i < n; ++i) v.push_back(value);
+    p.stop();
+    counted = log.totals();
+  });
+  double per = m.items ? double(m.items) : 1.0;
+  m.extra.push_back({"allocations", double(counted.allocations)});
+  m.extra.push_back({"frees", double(counted.frees)});
+  m.extra.push_back({"copies", double(counted.copies)});
+  m.extra.push_back({"moves", double(counted.moves)});
+  m.extra.push_back({"bytes_moved", double(counted.bytes_moved)});
+  m.extra.push_back({"bytes_copied", double(counted.bytes_copied)});
+  m.extra.push_back({"moves_per_element", double(counted.moves) / per});
+  rep.add(std::move(m));
+}
+
+template <class T>
+void run_type(const bench::options& opt, bench::reporter& rep) {
+  for (std::size_t n : opt.sizes())
+  {
+    scenario<T>(opt, rep, "push_back", n);
+    scenario<T>(opt, rep, "reserve_push_back", n);
+    scenario<T>(opt, rep, "shrink_to_fit", n);
+  }
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  run_type<int>(opt, rep);
+  run_type<bench::pod64>(opt, rep);
+  trace_log::instance().clear();
+  trace_log::instance().record_events(true);
+}
+
+bench::registration reg("trace", &run);
+
+} // namespace
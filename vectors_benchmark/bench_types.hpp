@@ -0,0 +1,77 @@
+//
+//  bench_types.hpp
+//  vectors_benchmark
+//
+// What?
+// Element types the suites sweep over, plus make_value<T>(i) to build the i-th value of each
+//
+// How?
+// - int        : what every demo in main.cpp stores
+// - pod64      : a 64-byte trivially copyable record (one cache line)
+// - std::string: long enough to defeat the small string optimisation, so copies allocate
+// - move_only  : not copyable, with a non-trivial move constructor
+
+#ifndef bench_types_hpp
+#define bench_types_hpp
+
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+struct pod64 {
+  std::int64_t v[8];
+
+  friend bool operator==(const pod64& a, const pod64& b) {
+    for (int i = 0; i < 8; ++i)
+      if (a.v[i] != b.v[i]) return false;
+    return true;
+  }
+  friend bool operator<(const pod64& a, const pod64& b) {
+    for (int i = 0; i < 8; ++i)
+      if (a.v[i] != b.v[i]) return a.v[i] < b.v[i];
+    return false;
+  }
+};
+
+struct move_only {
+  int value = 0;
+
+  move_only() = default;
+  explicit move_only(int v) : value(v) {}
+  move_only(const move_only&) = delete;
+  move_only& operator=(const move_only&) = delete;
+  move_only(move_only&& other) noexcept : value(other.value) { other.value = 0; }
+  move_only& operator=(move_only&& other) noexcept {
+    value = other.value;
+    other.value = 0;
+    return *this;
+  }
+
+  friend bool operator==(const move_only& a, const move_only& b) { return a.value == b.value; }
+  friend bool operator<(const move_only& a, const move_only& b) { return a.value < b.value; }
+};
+
+template <class T> struct type_name;
+template <> struct type_name<int> { static constexpr const char* value = "int"; };
+template <> struct type_name<pod64> { static constexpr const char* value = "pod64"; };
+template <> struct type_name<std::string> { static constexpr const char* value = "string"; };
+template <> struct type_name<move_only> { static constexpr const char* value = "move_only"; };
+
+template <class T> T make_value(std::size_t i);
+template <> inline int make_value<int>(std::size_t i) { return int(i); }
+template <> inline pod64 make_value<pod64>(std::size_t i) {
+  pod64 p;
+  for (int k = 0; k < 8; ++k) p.v[k] = std::int64_t(i) + k;
+  return p;
+}
+template <> inline std::string make_value<std::string>(std::size_t i) {
+  std::string s = "vectors_in_cpp element ";
+  s += std::to_string(i);
+  return s;
+}
+template <> inline move_only make_value<move_only>(std::size_t i) { return move_only(int(i)); }
+
+} // namespace bench
+
+#endif /* bench_types_hpp */
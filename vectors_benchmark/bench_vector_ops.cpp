@@ -0,0 +1,290 @@
+//
+//  bench_vector_ops.cpp
+//  vectors_benchmark
+//
+// What?
+// Every std::vector section of vectors_in_cpp/main.cpp as a parameterized microbenchmark
+//  assign, at, push_back, emplace, insert, erase, resize, shrink_to_fit, swap, == and <
+// swept over element count (10 .. 10^8), element type and allocator
+//
+// How?
+// Each op sets up its vectors outside the timed region and times only the operation itself.
+// Bulk ops (assign, at, push_back, resize, comparisons) count one item per element,
+// point ops (emplace, insert, erase, swap) count one item per call.
+
+#include "bench.hpp"
+#include "bench_types.hpp"
+
+#include <algorithm>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Allocators
+//  Each kind exposes the vector type it produces and an arena that owns whatever the vectors allocate from.
+//  A fresh arena is created for every sample, so monotonic memory does not pile up across repetitions.
+struct std_alloc {
+  static constexpr const char* name = "std";
+  template <class T> using vector = std::vector<T, bench::tally_allocator<T>>;
+  struct arena {
+    template <class T> vector<T> make() { return vector<T>(); }
+  };
+};
+
+struct pmr_monotonic {
+  static constexpr const char* name = "pmr_monotonic";
+  template <class T> using vector = std::pmr::vector<T>;
+  struct arena {
+    std::pmr::monotonic_buffer_resource upstream;
+    bench::tally_resource tally {&upstream};
+    template <class T> vector<T> make() { return vector<T>(&tally); }
+  };
+};
+
+struct pmr_pool {
+  static constexpr const char* name = "pmr_pool";
+  template <class T> using vector = std::pmr::vector<T>;
+  struct arena {
+    std::pmr::unsynchronized_pool_resource upstream;
+    bench::tally_resource tally {&upstream};
+    template <class T> vector<T> make() { return vector<T>(&tally); }
+  };
+};
+
+template <class T>
+using copyable = std::is_copy_constructible<T>;
+
+template <class Vec>
+void fill(Vec& v, std::size_t n) {
+  using T = typename Vec::value_type;
+  v.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) v.push_back(bench::make_value<T>(i));
+}
+
+// point ops touch at most this many positions per sample, so large n stays affordable
+std::size_t point_ops(std::size_t n) { return std::min<std::size_t>(n, 256); }
+
+template <class T, class A>
+class vector_ops {
+public:
+  vector_ops(const bench::options& opt, bench::reporter& rep) : opt_(opt), rep_(rep) {}
+
+  void run() {
+    for (std::size_t n : opt_.sizes()) {
+      if constexpr (copyable<T>::value) op_assign(n);
+      op_at(n);
+      op_push_back(n);
+      op_emplace(n);
+      op_insert(n);
+      op_erase(n);
+      op_resize(n);
+      op_shrink_to_fit(n);
+      op_swap(n);
+      op_relational(n);
+    }
+  }
+
+private:
+  using vector = typename A::template vector<T>;
+
+  template <class Fn>
+  void measure(const char* op, std::size_t n, std::uint64_t items, Fn&& fn) {
+    std::string case_name = std::string("vector_ops/") + op + '/' + bench::type_name<T>::value + '/' + A::name;
+    if (!opt_.selected(case_name)) return;
+    bench::measurement m;
+    m.suite = "vector_ops";
+    m.op = op;
+    m.type = bench::type_name<T>::value;
+    m.variant = A::name;
+    m.n = n;
+    m.items = items;
+    m.best = bench::run_case(opt_, fn);
+    rep_.add(std::move(m));
+  }
+
+  // first_assign.assign (7,100);
+  void op_assign(std::size_t n) {
+    const T value = bench::make_value<T>(100);
+    measure("assign", n, n, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      p.start();
+      v.assign(n, value);
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_at.at(i)
+  void op_at(std::size_t n) {
+    measure("at", n, n, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      fill(v, n);
+      p.start();
+      for (std::size_t i = 0; i < v.size(); ++i) bench::do_not_optimize(v.at(i));
+      p.stop();
+    });
+  }
+
+  // vec_capacity.push_back(i) from an empty vector, so every reallocation is included
+  void op_push_back(std::size_t n) {
+    measure("push_back", n, n, [&](bench::probe& p) {
+      std::vector<T> src;
+      fill(src, n);
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      p.start();
+      for (std::size_t i = 0; i < n; ++i) {
+        if constexpr (copyable<T>::value) v.push_back(src[i]);
+        else v.push_back(std::move(src[i]));
+      }
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_emplace.emplace (vec_emplace.begin()+1, 100);
+  void op_emplace(std::size_t n) {
+    const std::size_t k = point_ops(n);
+    measure("emplace", n, k, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      fill(v, n);
+      v.reserve(n + k);
+      p.start();
+      for (std::size_t i = 0; i < k; ++i) v.emplace(v.begin() + 1, bench::make_value<T>(i));
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_insert.insert (it, 200) in the middle of the vector
+  void op_insert(std::size_t n) {
+    const std::size_t k = point_ops(n);
+    measure("insert", n, k, [&](bench::probe& p) {
+      std::vector<T> src;
+      fill(src, k);
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      fill(v, n);
+      v.reserve(n + k);
+      p.start();
+      for (std::size_t i = 0; i < k; ++i) v.insert(v.begin() + v.size() / 2, std::move(src[i]));
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_erase.erase (vec_erase.begin()+5);
+  void op_erase(std::size_t n) {
+    const std::size_t k = point_ops(n / 2);
+    if (k == 0 || n < k + 5) return;
+    measure("erase", n, k, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      fill(v, n);
+      p.start();
+      for (std::size_t i = 0; i < k; ++i) v.erase(v.begin() + 5);
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_resize.resize(12); value-initializes the new elements
+  void op_resize(std::size_t n) {
+    measure("resize", n, n, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      p.start();
+      v.resize(n);
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // vec_shrink_to_fit.resize(n/10); vec_shrink_to_fit.shrink_to_fit();
+  void op_shrink_to_fit(std::size_t n) {
+    const std::size_t kept = std::max<std::size_t>(n / 10, 1);
+    measure("shrink_to_fit", n, kept, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector v = arena.template make<T>();
+      fill(v, n);
+      v.resize(kept);
+      p.start();
+      v.shrink_to_fit();
+      p.stop();
+      bench::do_not_optimize(v.data());
+    });
+  }
+
+  // std::swap(vec_1_swap_vec, vec_2_swap_vec);
+  void op_swap(std::size_t n) {
+    const std::size_t k = 1000;
+    measure("swap", n, k, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector a = arena.template make<T>();
+      vector b = arena.template make<T>();
+      fill(a, n);
+      fill(b, n / 2);
+      p.start();
+      for (std::size_t i = 0; i < k; ++i) {
+        a.swap(b);
+        bench::clobber_memory();
+      }
+      p.stop();
+    });
+  }
+
+  // vec_1_relational_op==vec_2_relational_op, vec_1_relational_op< vec_2_relational_op
+  // Equal contents are the worst case for both: every element has to be compared.
+  void op_relational(std::size_t n) {
+    measure("equal", n, n, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector a = arena.template make<T>();
+      vector b = arena.template make<T>();
+      fill(a, n);
+      fill(b, n);
+      p.start();
+      bool eq = a == b;
+      p.stop();
+      bench::do_not_optimize(eq);
+    });
+    measure("less", n, n, [&](bench::probe& p) {
+      typename A::arena arena;
+      vector a = arena.template make<T>();
+      vector b = arena.template make<T>();
+      fill(a, n);
+      fill(b, n);
+      p.start();
+      bool lt = a < b;
+      p.stop();
+      bench::do_not_optimize(lt);
+    });
+  }
+
+  const bench::options& opt_;
+  bench::reporter& rep_;
+};
+
+template <class T>
+void run_type(const bench::options& opt, bench::reporter& rep) {
+  vector_ops<T, std_alloc>(opt, rep).run();
+  vector_ops<T, pmr_monotonic>(opt, rep).run();
+  vector_ops<T, pmr_pool>(opt, rep).run();
+}
+
+void run(const bench::options& opt, bench::reporter& rep) {
+  run_type<int>(opt, rep);
+  run_type<bench::pod64>(opt, rep);
+  run_type<std::string>(opt, rep);
+  run_type<bench::move_only>(opt, rep);
+}
+
+bench::registration reg("vector_ops", &run);
+
+} // namespace
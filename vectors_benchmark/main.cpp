@@ -0,0 +1,90 @@
+//
+//  main.cpp
+//  vectors_benchmark
+//
+// What?
+// Benchmark driver for the containers and demos in vectors_in_cpp
+// Runs every registered suite (or the ones matching --filter) and optionally writes a JSON report,
+// so results can be compared across compilers and standard libraries
+//
+// How?
+// Build (from the repository root):
+//  c++ -std=c++17 -O2 -pthread -I vectors_in_cpp vectors_benchmark/*.cpp vectors_in_cpp/simd_kernels.cpp -o vectors_benchmark/vectors_benchmark
+// Run:
+//  vectors_benchmark --filter=vector_ops/push_back --max-n=100000000 --json=results.json
+//
+// Options:
+//  --filter=<substr>   only run cases whose "suite/op/type/variant" name contains <substr>
+//  --min-n=<n>         smallest element count of the 10^k sweep (default 10)
+//  --max-n=<n>         largest element count of the 10^k sweep (default 10^6)
+//  --min-time=<s>      minimum time spent repeating one case (default 0.05)
+//  --max-reps=<n>      maximum number of repetitions of one case (default 50)
+//  --threads=<n>       largest thread count for the multi-threaded suites (default: all cores)
+//  --json=<path>       write the JSON report to <path> ("-" for stdout)
+//  --list              list registered suites and exit
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+int main(int argc, const char * argv[]) {
+
+  bench::options opt;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto value = [&](const char* key) -> const char* {
+      std::size_t len = std::strlen(key);
+      if (arg.compare(0, len, key) == 0 && arg.size() > len && arg[len] == '=') return argv[i] + len + 1;
+      return nullptr;
+    };
+    if (const char* v = value("--filter")) opt.filter = v;
+    else if (const char* v = value("--min-n")) opt.min_n = std::strtoull(v, nullptr, 10);
+    else if (const char* v = value("--max-n")) opt.max_n = std::strtoull(v, nullptr, 10);
+    else if (const char* v = value("--min-time")) opt.min_time_s = std::strtod(v, nullptr);
+    else if (const char* v = value("--max-reps")) opt.max_reps = unsigned(std::strtoul(v, nullptr, 10));
+    else if (const char* v = value("--threads")) opt.max_threads = unsigned(std::strtoul(v, nullptr, 10));
+    else if (const char* v = value("--json")) opt.json_path = v;
+    else if (arg == "--list")
+    {
+      for (auto& s : bench::suites()) std::cout << s.name << '\n';
+      return 0;
+    }
+    else
+    {
+      std::cerr << "unknown option: " << arg << '\n';
+      return 2;
+    }
+  }
+  if (opt.max_reps == 0) opt.max_reps = 1;
+
+  // with --json=- the table goes to stderr so stdout stays valid JSON
+  std::ostream& table = opt.json_path == "-" ? std::cerr : std::cout;
+  table << "# " << bench::compiler_name() << ", " << bench::stdlib_name() << '\n';
+  bench::reporter rep(table);
+  // suites check opt.selected() per case, so a filter can name a suite, an op, a type or a variant
+  for (auto& s : bench::suites())
+    s.run(opt, rep);
+
+  if (opt.json_path == "-")
+  {
+    rep.write_json(std::cout);
+  }
+  else if (!opt.json_path.empty())
+  {
+    std::ofstream out(opt.json_path);
+    if (!out)
+    {
+      std::cerr << "cannot write " << opt.json_path << '\n';
+      return 1;
+    }
+    rep.write_json(out);
+  }
+
+  return 0;
+}
@@ -0,0 +1,169 @@
+//
+//  arena.hpp
+//  vectors_in_cpp
+//
+// What?
+// std::pmr memory resources for short-lived vectors
+// - arena_resource     : monotonic (bump pointer) arena, deallocate() is a no-op and everything is
+//                        returned to the upstream resource at once by release() or the destructor
+// - thread_local_pool(): an unsynchronized pool resource owned by the calling thread, no locks at all
+// - counting_resource  : forwards to another resource and counts allocations, live and peak bytes
+//
+// How?
+// - arena_resource arena;  std::pmr::vector<int> v (&arena);
+// - std::pmr::vector<int> v (thread_local_pool());
+// - std::pmr::set_default_resource(&arena);   // every std::pmr::vector built afterwards uses the arena
+//
+// Memory from thread_local_pool() must be freed on the thread that allocated it, and before that
+// thread exits: a vector built on it must not be handed to another thread.
+
+#ifndef arena_hpp
+#define arena_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+class arena_resource : public std::pmr::memory_resource {
+public:
+  explicit arena_resource(std::size_t initial_chunk = 4096,
+                          std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+    : upstream_(upstream), first_chunk_(std::max<std::size_t>(initial_chunk, 64)), next_chunk_(first_chunk_) {}
+
+  // start out in a caller supplied buffer (e.g. on the stack), only go upstream when it is full
+  arena_resource(void* buffer, std::size_t size,
+                 std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+    : upstream_(upstream), first_chunk_(std::max<std::size_t>(size, 64)), next_chunk_(first_chunk_),
+      cur_(static_cast<char*>(buffer)), end_(static_cast<char*>(buffer) + size),
+      initial_(static_cast<char*>(buffer)), initial_size_(size) {}
+
+  arena_resource(const arena_resource&) = delete;
+  arena_resource& operator=(const arena_resource&) = delete;
+
+  ~arena_resource() override { release(); }
+
+  // give every chunk back to upstream; all memory handed out by the arena becomes invalid
+  void release() noexcept {
+    while (chunks_) {
+      chunk* next = chunks_->next;
+      upstream_->deallocate(chunks_, chunks_->size, alignof(std::max_align_t));
+      chunks_ = next;
+    }
+    cur_ = initial_;
+    end_ = initial_ ? initial_ + initial_size_ : nullptr;
+    next_chunk_ = first_chunk_;
+    bytes_reserved_ = 0;
+  }
+
+  // bytes taken from upstream (not counting the initial buffer)
+  std::size_t bytes_reserved() const noexcept { return bytes_reserved_; }
+  std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+private:
+  struct chunk {
+    chunk* next;
+    std::size_t size;
+  };
+
+  // upstream chunks stop doubling here (requests larger than this still get a chunk of their size)
+  static constexpr std::size_t max_chunk = std::size_t(64) << 20;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (void* p = bump(bytes, alignment)) return p;
+    std::size_t needed = sizeof(chunk) + bytes + alignment;
+    std::size_t size = std::max(next_chunk_, needed);
+    chunk* c = static_cast<chunk*>(upstream_->allocate(size, alignof(std::max_align_t)));
+    c->next = chunks_;
+    c->size = size;
+    chunks_ = c;
+    bytes_reserved_ += size;
+    // geometric, so n bytes take O(log n) trips upstream; a single large request gets a chunk of
+    // its own size but does not inflate the ones after it
+    if (next_chunk_ < max_chunk) next_chunk_ = std::min(next_chunk_ * 2, max_chunk);
+    cur_ = reinterpret_cast<char*>(c + 1);
+    end_ = reinterpret_cast<char*>(c) + size;
+    return bump(bytes, alignment);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  void* bump(std::size_t bytes, std::size_t alignment) noexcept {
+    if (!cur_) return nullptr;
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(cur_);
+    std::uintptr_t aligned = (p + alignment - 1) & ~std::uintptr_t(alignment - 1);
+    if (aligned + bytes > reinterpret_cast<std::uintptr_t>(end_)) return nullptr;
+    cur_ = reinterpret_cast<char*>(aligned + bytes);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  std::pmr::memory_resource* upstream_;
+  std::size_t first_chunk_;
+  std::size_t next_chunk_;
+  char* cur_ = nullptr;
+  char* end_ = nullptr;
+  char* initial_ = nullptr;
+  std::size_t initial_size_ = 0;
+  chunk* chunks_ = nullptr;
+  std::size_t bytes_reserved_ = 0;
+};
+
+
+// thread_local_pool()
+//  One std::pmr::unsynchronized_pool_resource per thread, created on first use.
+//  Because no other thread ever sees it there is no locking and no cross-thread free contention.
+inline std::pmr::memory_resource* thread_local_pool() {
+  thread_local std::pmr::unsynchronized_pool_resource pool (std::pmr::new_delete_resource());
+  return &pool;
+}
+
+
+struct resource_stats {
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t bytes_allocated = 0;
+  std::uint64_t live_bytes = 0;
+  std::uint64_t peak_bytes = 0;
+};
+
+// counting_resource
+//  Not thread safe: meant to sit in front of one of the resources above in single threaded code.
+class counting_resource : public std::pmr::memory_resource {
+public:
+  explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+    : upstream_(upstream) {}
+
+  const resource_stats& stats() const noexcept { return stats_; }
+  // start a new peak measurement from the bytes that are live right now
+  void reset_peak() noexcept { stats_.peak_bytes = stats_.live_bytes; }
+  std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void* p = upstream_->allocate(bytes, alignment);
+    ++stats_.allocations;
+    stats_.bytes_allocated += bytes;
+    stats_.live_bytes += bytes;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.live_bytes);
+    return p;
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    ++stats_.deallocations;
+    stats_.live_bytes -= bytes;
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+  resource_stats stats_;
+};
+
+#endif /* arena_hpp */
@@ -0,0 +1,158 @@
+//
+//  batch_erase.hpp
+//  vectors_in_cpp
+//
+// What?
+// Remove many elements of a vector in one pass, keeping the order of the rest, instead of one erase()
+// per element as in vec_erase (every erase() shifts the whole tail again: O(n) each, O(n * k) in all)
+// - batch::erase_indices(v, indices): the elements at these positions (any order, duplicates allowed)
+// - batch::erase_mask(v, mask)      : the elements whose bit is set in a batch::removal_mask
+// - batch::erase_if(v, pred)        : the elements pred returns true for
+// Each returns the number of elements removed and moves every kept element at most once.
+//
+// How?
+// - batch::erase_indices(vec_erase, {5, 0, 1, 2});   // erase(begin()+5) then erase(begin(), begin()+3)
+// - batch::removal_mask mask (vec.size());  mask.set(i); ...  batch::erase_mask(vec, mask);
+// Works on contiguous vectors (std::vector, small_vector, std::pmr::vector ...).
+// The kept elements move down run by run between removed ones, with memmove for trivially copyable
+// types. Vectors of int go through simd::compress instead (AVX2/AVX-512 when available; erase_if
+// builds the mask 64 elements at a time), so simd_kernels.cpp has to be built in.
+
+#ifndef batch_erase_hpp
+#define batch_erase_hpp
+
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace batch {
+
+// one bit per element, set = remove
+class removal_mask {
+public:
+  removal_mask() = default;
+  explicit removal_mask(std::size_t n) : size_(n), words_((n + 63) / 64) {}
+
+  void set(std::size_t i) noexcept { words_[i / 64] |= std::uint64_t(1) << (i % 64); }
+  void reset(std::size_t i) noexcept { words_[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+  bool test(std::size_t i) const noexcept { return (words_[i / 64] >> (i % 64)) & 1; }
+
+  std::size_t size() const noexcept { return size_; }
+  std::size_t count() const noexcept {
+    std::size_t n = 0;
+    for (std::uint64_t w : words_) n += std::size_t(__builtin_popcountll(w));
+    return n;
+  }
+  const std::uint64_t* words() const noexcept { return words_.data(); }
+
+private:
+  std::size_t size_ = 0;
+  std::vector<std::uint64_t> words_;
+};
+
+namespace batch_detail {
+
+template <class Vec>
+constexpr bool is_int_vector = std::is_same<typename Vec::value_type, std::int32_t>::value;
+
+// move [first, last) down to out (out <= first, the ranges may overlap)
+template <class T>
+void move_down(T* p, std::size_t first, std::size_t last, std::size_t out) {
+  if (first == out || first == last) return;
+  if constexpr (std::is_trivially_copyable<T>::value)
+    std::memmove(static_cast<void*>(p + out), static_cast<const void*>(p + first), (last - first) * sizeof(T));
+  else
+    std::move(p + first, p + last, p + out);
+}
+
+// for_each_removed(f) calls f(r) for every removed index, increasing; returns the number kept
+template <class T, class ForEachRemoved>
+std::size_t compact(T* p, std::size_t n, ForEachRemoved for_each_removed) {
+  std::size_t out = 0;
+  std::size_t run = 0;   // start of the current run of kept elements
+  for_each_removed([&](std::size_t r) {
+    move_down(p, run, r, out);
+    out += r - run;
+    run = r + 1;
+  });
+  move_down(p, run, n, out);
+  return out + (n - run);
+}
+
+template <class Vec>
+std::size_t truncate(Vec& v, std::size_t kept) {
+  std::size_t removed = v.size() - kept;
+  v.erase(v.begin() + std::ptrdiff_t(kept), v.end());
+  return removed;
+}
+
+} // namespace batch_detail
+
+template <class Vec>
+std::size_t erase_mask(Vec& v, const removal_mask& mask) {
+  if (mask.size() != v.size()) throw std::invalid_argument("batch::erase_mask: mask and vector sizes differ");
+  const std::uint64_t* words = mask.words();
+  std::size_t kept;
+  if constexpr (batch_detail::is_int_vector<Vec>) {
+    kept = simd::compress(v.data(), v.size(), words, v.data());
+  } else {
+    kept = batch_detail::compact(v.data(), v.size(), [&](auto&& removed) {
+      for (std::size_t w = 0; w < (mask.size() + 63) / 64; ++w)
+        for (std::uint64_t bits = words[w]; bits; bits &= bits - 1)
+          removed(w * 64 + std::size_t(__builtin_ctzll(bits)));
+    });
+  }
+  return batch_detail::truncate(v, kept);
+}
+
+// indices may come in any order and repeat; all of them are checked before anything is removed
+template <class Vec, class Indices>
+std::size_t erase_indices(Vec& v, const Indices& indices) {
+  std::vector<std::size_t> sorted (std::begin(indices), std::end(indices));
+  if (!std::is_sorted(sorted.begin(), sorted.end())) std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  if (!sorted.empty() && sorted.back() >= v.size()) throw std::out_of_range("batch::erase_indices");
+  std::size_t kept = batch_detail::compact(v.data(), v.size(), [&](auto&& removed) {
+    for (std::size_t r : sorted) removed(r);
+  });
+  return batch_detail::truncate(v, kept);
+}
+template <class Vec>
+std::size_t erase_indices(Vec& v, std::initializer_list<std::size_t> indices) {
+  return erase_indices<Vec, std::initializer_list<std::size_t>>(v, indices);
+}
+
+// the remove-erase idiom; for ints pred fills a 64 bit mask that simd::compress then applies
+template <class Vec, class Pred>
+std::size_t erase_if(Vec& v, Pred pred) {
+  if constexpr (batch_detail::is_int_vector<Vec>) {
+    std::int32_t* p = v.data();
+    const std::size_t n = v.size();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < n; i += 64)
+    {
+      std::size_t len = std::min<std::size_t>(64, n - i);
+      std::uint64_t remove = 0;
+      for (std::size_t j = 0; j < len; ++j) remove |= std::uint64_t(bool(pred(p[i + j]))) << j;
+      kept += simd::compress(p + i, len, &remove, p + kept);
+    }
+    return batch_detail::truncate(v, kept);
+  } else {
+    auto new_end = std::remove_if(v.begin(), v.end(), pred);
+    std::size_t removed = std::size_t(v.end() - new_end);
+    v.erase(new_end, v.end());
+    return removed;
+  }
+}
+
+} // namespace batch
+
+#endif /* batch_erase_hpp */
@@ -0,0 +1,388 @@
+//
+//  checked_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// checked_vector<T> is std::vector<T> with the undefined behaviour main.cpp warns about turned into
+// a diagnosed failure:
+// - operator[] out of range, front() / back() / pop_back() on an empty vector
+// - dereferencing (or inserting / erasing at) an iterator that an earlier change invalidated, such as
+//   vec_insert_it after vec_insert.insert() ("no longer valid, get a new one")
+// - dereferencing an iterator outside [begin, end)
+// Each check is one compare and a branch marked unlikely; the failure path is out of line. at() still
+// throws std::out_of_range as it does on std::vector.
+// hardened_vector<T> is the build-time switch: checked_vector<T> with -DVECTORS_CHECKED, plain
+// std::vector<T> (no wrapper, no cost) without.
+//
+// How?
+// - hardened_vector<int> v = {1, 2, 3};   // in release builds exactly std::vector<int>
+// - v[3];                                 // checked build: "checked_vector: index out of range", abort
+// A failed check prints what failed to stderr and calls std::abort(); with -DVECTORS_CHECKED_THROW it
+// throws std::out_of_range (bad index) or std::logic_error (bad iterator) instead, for tests.
+//
+// Iterators carry the generation of their vector, which changes whenever a change may invalidate
+// them: a reallocation, insert/emplace anywhere but at the end, any erase, pop_back or shrinking
+// resize, clear, assign, assignment, swap and move. That is stricter than the standard in three
+// places: an insert or erase also invalidates the iterators before the position, pop_back and a
+// shrinking resize invalidate every iterator, not only the ones past the new end (which the bounds
+// check alone would accept again once the vector grows back), and swap/move invalidate iterators that
+// would follow the elements. The iterators insert/emplace/erase return are always current.
+// Iterator increments and comparisons are not checked, only uses; references and pointers (data())
+// are not checked at all.
+
+#ifndef checked_vector_hpp
+#define checked_vector_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace checked_detail {
+
+#if defined(__GNUC__)
+#define CHECKED_VECTOR_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define CHECKED_VECTOR_COLD __attribute__((noinline, cold))
+#else
+#define CHECKED_VECTOR_UNLIKELY(x) (x)
+#define CHECKED_VECTOR_COLD
+#endif
+
+enum class failure { index, iterator };
+
+[[noreturn]] CHECKED_VECTOR_COLD inline void fail(failure kind, const char* what) {
+#if defined(VECTORS_CHECKED_THROW)
+  if (kind == failure::index) throw std::out_of_range(what);
+  throw std::logic_error(what);
+#else
+  (void)kind;
+  std::fprintf(stderr, "%s\n", what);
+  std::abort();
+#endif
+}
+
+inline void require(bool ok, failure kind, const char* what) {
+  if (CHECKED_VECTOR_UNLIKELY(!ok)) fail(kind, what);
+}
+
+} // namespace checked_detail
+
+template <class T, class Alloc = std::allocator<T>>
+class checked_vector {
+  using base = std::vector<T, Alloc>;
+  template <class It>
+  using require_iterator = typename std::iterator_traits<It>::iterator_category;
+
+  template <bool Const>
+  class iter {
+    using owner_type = std::conditional_t<Const, const checked_vector, checked_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    iter() noexcept = default;
+    // iterator to const_iterator
+    template <bool C = Const, class = std::enable_if_t<C>>
+    iter(const iter<false>& other) noexcept : p_(other.p_), owner_(other.owner_), generation_(other.generation_) {}
+
+    reference operator*() const { return *checked(p_); }
+    pointer operator->() const { return checked(p_); }
+    reference operator[](difference_type d) const { return *checked(p_ + d); }
+
+    iter& operator++() noexcept { ++p_; return *this; }
+    iter operator++(int) noexcept { iter t = *this; ++p_; return t; }
+    iter& operator--() noexcept { --p_; return *this; }
+    iter operator--(int) noexcept { iter t = *this; --p_; return t; }
+    iter& operator+=(difference_type d) noexcept { p_ += d; return *this; }
+    iter& operator-=(difference_type d) noexcept { p_ -= d; return *this; }
+    friend iter operator+(iter it, difference_type d) noexcept { return it += d; }
+    friend iter operator+(difference_type d, iter it) noexcept { return it += d; }
+    friend iter operator-(iter it, difference_type d) noexcept { return it -= d; }
+    friend difference_type operator-(const iter& a, const iter& b) noexcept { return a.p_ - b.p_; }
+
+    friend bool operator==(const iter& a, const iter& b) noexcept { return a.p_ == b.p_; }
+    friend bool operator!=(const iter& a, const iter& b) noexcept { return a.p_ != b.p_; }
+    friend bool operator<(const iter& a, const iter& b) noexcept { return a.p_ < b.p_; }
+    friend bool operator>(const iter& a, const iter& b) noexcept { return a.p_ > b.p_; }
+    friend bool operator<=(const iter& a, const iter& b) noexcept { return a.p_ <= b.p_; }
+    friend bool operator>=(const iter& a, const iter& b) noexcept { return a.p_ >= b.p_; }
+
+  private:
+    friend class checked_vector;
+    iter(pointer p, owner_type* owner) noexcept : p_(p), owner_(owner), generation_(owner->generation_) {}
+
+    bool current() const noexcept { return owner_ && owner_->generation_ == generation_; }
+
+    pointer checked(pointer p) const {
+      checked_detail::require(current(), checked_detail::failure::iterator, "checked_vector: iterator used after it was invalidated");
+      // one unsigned compare covers both ends
+      checked_detail::require(std::size_t(p - owner_->v_.data()) < owner_->v_.size(), checked_detail::failure::iterator,
+                              "checked_vector: iterator dereferenced outside [begin, end)");
+      return p;
+    }
+
+    pointer p_ = nullptr;
+    owner_type* owner_ = nullptr;
+    std::uint64_t generation_ = 0;
+  };
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = typename base::size_type;
+  using difference_type = typename base::difference_type;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = typename base::pointer;
+  using const_pointer = typename base::const_pointer;
+  using iterator = iter<false>;
+  using const_iterator = iter<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // constructors
+  checked_vector() = default;
+  explicit checked_vector(const Alloc& alloc) noexcept : v_(alloc) {}
+  explicit checked_vector(size_type n, const Alloc& alloc = Alloc()) : v_(n, alloc) {}
+  checked_vector(size_type n, const T& value, const Alloc& alloc = Alloc()) : v_(n, value, alloc) {}
+  template <class It, class = require_iterator<It>>
+  checked_vector(It first, It last, const Alloc& alloc = Alloc()) : v_(first, last, alloc) {}
+  checked_vector(std::initializer_list<T> init, const Alloc& alloc = Alloc()) : v_(init, alloc) {}
+  checked_vector(const checked_vector& other) : v_(other.v_) {}
+  checked_vector(checked_vector&& other) noexcept : v_(std::move(other.v_)) { ++other.generation_; }
+
+  checked_vector& operator=(const checked_vector& other) {
+    if (this != &other)
+    {
+      v_ = other.v_;
+      ++generation_;
+    }
+    return *this;
+  }
+  checked_vector& operator=(checked_vector&& other) noexcept(std::is_nothrow_move_assignable<base>::value) {
+    if (this != &other)
+    {
+      v_ = std::move(other.v_);
+      ++generation_;
+      ++other.generation_;
+    }
+    return *this;
+  }
+  checked_vector& operator=(std::initializer_list<T> init) {
+    v_ = init;
+    ++generation_;
+    return *this;
+  }
+
+  void assign(size_type n, const T& value) {
+    v_.assign(n, value);
+    ++generation_;
+  }
+  template <class It, class = require_iterator<It>>
+  void assign(It first, It last) {
+    v_.assign(first, last);
+    ++generation_;
+  }
+  void assign(std::initializer_list<T> init) {
+    v_.assign(init);
+    ++generation_;
+  }
+
+  allocator_type get_allocator() const noexcept { return v_.get_allocator(); }
+
+  // element access
+  reference at(size_type i) { return v_.at(i); }
+  const_reference at(size_type i) const { return v_.at(i); }
+  reference operator[](size_type i) {
+    checked_detail::require(i < v_.size(), checked_detail::failure::index, "checked_vector: index out of range");
+    return v_[i];
+  }
+  const_reference operator[](size_type i) const {
+    checked_detail::require(i < v_.size(), checked_detail::failure::index, "checked_vector: index out of range");
+    return v_[i];
+  }
+  reference front() {
+    checked_detail::require(!v_.empty(), checked_detail::failure::index, "checked_vector: front() on an empty vector");
+    return v_.front();
+  }
+  const_reference front() const {
+    checked_detail::require(!v_.empty(), checked_detail::failure::index, "checked_vector: front() on an empty vector");
+    return v_.front();
+  }
+  reference back() {
+    checked_detail::require(!v_.empty(), checked_detail::failure::index, "checked_vector: back() on an empty vector");
+    return v_.back();
+  }
+  const_reference back() const {
+    checked_detail::require(!v_.empty(), checked_detail::failure::index, "checked_vector: back() on an empty vector");
+    return v_.back();
+  }
+  T* data() noexcept { return v_.data(); }
+  const T* data() const noexcept { return v_.data(); }
+
+  // iterators
+  iterator begin() noexcept { return {v_.data(), this}; }
+  const_iterator begin() const noexcept { return {v_.data(), this}; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return {v_.data() + v_.size(), this}; }
+  const_iterator end() const noexcept { return {v_.data() + v_.size(), this}; }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return v_.empty(); }
+  size_type size() const noexcept { return v_.size(); }
+  size_type max_size() const noexcept { return v_.max_size(); }
+  size_type capacity() const noexcept { return v_.capacity(); }
+  void reserve(size_type n) {
+    const T* before = v_.data();
+    v_.reserve(n);
+    moved_from(before);
+  }
+  void shrink_to_fit() {
+    const T* before = v_.data();
+    v_.shrink_to_fit();
+    moved_from(before);
+  }
+
+  // modifiers
+  void clear() noexcept {
+    v_.clear();
+    ++generation_;
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  iterator insert(const_iterator pos, size_type n, const T& value) {
+    size_type at = index_of(pos);
+    v_.insert(v_.begin() + difference_type(at), n, value);
+    ++generation_;
+    return begin() + difference_type(at);
+  }
+  template <class It, class = require_iterator<It>>
+  iterator insert(const_iterator pos, It first, It last) {
+    size_type at = index_of(pos);
+    v_.insert(v_.begin() + difference_type(at), first, last);
+    ++generation_;
+    return begin() + difference_type(at);
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) { return insert(pos, init.begin(), init.end()); }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    size_type at = index_of(pos);
+    if (at == v_.size())
+    {
+      emplace_back(std::forward<Args>(args)...);
+      return end() - 1;
+    }
+    v_.emplace(v_.begin() + difference_type(at), std::forward<Args>(args)...);
+    ++generation_;
+    return begin() + difference_type(at);
+  }
+
+  iterator erase(const_iterator pos) {
+    size_type at = index_of(pos);
+    checked_detail::require(at < v_.size(), checked_detail::failure::iterator, "checked_vector: erase(end())");
+    return erase_range(at, at + 1);
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    size_type from = index_of(first), to = index_of(last);
+    checked_detail::require(from <= to, checked_detail::failure::iterator, "checked_vector: erase(first, last) with last before first");
+    return erase_range(from, to);
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    const T* before = v_.data();
+    v_.emplace_back(std::forward<Args>(args)...);
+    moved_from(before);
+    return v_.back();
+  }
+  // the bounds check alone would accept an iterator to the popped element once the vector grows back
+  void pop_back() {
+    checked_detail::require(!v_.empty(), checked_detail::failure::index, "checked_vector: pop_back() on an empty vector");
+    v_.pop_back();
+    ++generation_;
+  }
+
+  void resize(size_type n) {
+    const T* before = v_.data();
+    if (n < v_.size()) ++generation_;   // as pop_back
+    v_.resize(n);
+    moved_from(before);
+  }
+  void resize(size_type n, const T& value) {
+    const T* before = v_.data();
+    if (n < v_.size()) ++generation_;
+    v_.resize(n, value);
+    moved_from(before);
+  }
+
+  void swap(checked_vector& other) noexcept {
+    v_.swap(other.v_);
+    ++generation_;
+    ++other.generation_;
+  }
+  friend void swap(checked_vector& a, checked_vector& b) noexcept { a.swap(b); }
+
+  friend bool operator==(const checked_vector& a, const checked_vector& b) { return a.v_ == b.v_; }
+  friend bool operator!=(const checked_vector& a, const checked_vector& b) { return a.v_ != b.v_; }
+  friend bool operator<(const checked_vector& a, const checked_vector& b) { return a.v_ < b.v_; }
+  friend bool operator>(const checked_vector& a, const checked_vector& b) { return a.v_ > b.v_; }
+  friend bool operator<=(const checked_vector& a, const checked_vector& b) { return a.v_ <= b.v_; }
+  friend bool operator>=(const checked_vector& a, const checked_vector& b) { return a.v_ >= b.v_; }
+
+private:
+  // a position argument must be a current iterator of this vector, in [begin, end]
+  size_type index_of(const_iterator pos) const {
+    checked_detail::require(pos.owner_ == this, checked_detail::failure::iterator, "checked_vector: iterator of another vector");
+    checked_detail::require(pos.generation_ == generation_, checked_detail::failure::iterator,
+                            "checked_vector: iterator used after it was invalidated");
+    checked_detail::require(pos.p_ >= v_.data() && pos.p_ <= v_.data() + v_.size(), checked_detail::failure::iterator,
+                            "checked_vector: iterator outside [begin, end]");
+    return size_type(pos.p_ - v_.data());
+  }
+
+  // even at the end, as pop_back
+  iterator erase_range(size_type from, size_type to) {
+    v_.erase(v_.begin() + difference_type(from), v_.begin() + difference_type(to));
+    if (from != to) ++generation_;
+    return begin() + difference_type(from);
+  }
+
+  // a new buffer invalidates every iterator
+  void moved_from(const T* before) noexcept {
+    if (v_.data() != before) ++generation_;
+  }
+
+  base v_;
+  std::uint64_t generation_ = 0;
+};
+
+// the build-time switch: checked in checked builds, std::vector itself otherwise
+#if defined(VECTORS_CHECKED)
+template <class T, class Alloc = std::allocator<T>> using hardened_vector = checked_vector<T, Alloc>;
+#else
+template <class T, class Alloc = std::allocator<T>> using hardened_vector = std::vector<T, Alloc>;
+#endif
+
+#endif /* checked_vector_hpp */
@@ -0,0 +1,680 @@
+//
+//  chunked_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// chunked_vector<T, ChunkSize> is a sequence container for the insert()/emplace()/erase() sections of
+// main.cpp done on large sequences: std::vector shifts every later element, chunked_vector only the
+// elements of one chunk
+// - the elements live in fixed-capacity chunks of ChunkSize elements, each one contiguous
+// - a Fenwick tree over the chunk sizes finds the chunk of an index in O(log n)
+// - insert into a full chunk splits it in two, erase merges a chunk that fell below a quarter full
+//   into a neighbour, so the chunks stay between ~1/4 and full
+// insert/erase in the middle cost O(log n + ChunkSize) plus an O(n / ChunkSize) index rebuild on every
+// split or merge, which happens at most once per ChunkSize / 4 operations on the same chunk.
+//
+// How?
+// Same interface as the demos use on std::vector, minus data()/capacity()/reserve() (not contiguous):
+// - chunked_vector<int> vec = {10,20,30};
+// - vec.emplace(vec.begin()+1, 100);  vec.erase(vec.begin()+5);  vec.erase(vec.begin(), vec.begin()+3);
+// Contiguous access, one chunk at a time:
+// - vec.for_each_chunk([](int* p, std::size_t n) { ... });
+// - for (std::size_t c = 0; c < vec.chunk_count(); ++c) use(vec.chunk_data(c), vec.chunk_size(c));
+// Iterators are random access; ++/-- are O(1), iterator arithmetic and begin()+k are O(log n).
+// Every insert and erase invalidates all iterators and references, as for std::vector.
+
+#ifndef chunked_vector_hpp
+#define chunked_vector_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chunked_detail {
+// about 4 KiB of elements per chunk
+template <class T>
+constexpr std::size_t default_chunk_size = std::max<std::size_t>(16, 4096 / sizeof(T));
+}
+
+template <class T, std::size_t ChunkSize = chunked_detail::default_chunk_size<T>>
+class chunked_vector {
+  static_assert(ChunkSize >= 4, "chunked_vector needs at least 4 elements per chunk");
+
+  template <class It>
+  using require_iterator = typename std::iterator_traits<It>::iterator_category;
+  template <class It>
+  using is_forward = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+  struct chunk {
+    std::size_t size = 0;
+    alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+    T* items() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  template <bool Const>
+  class basic_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    basic_iterator() noexcept = default;
+    // iterator -> const_iterator
+    template <bool C = Const, class = std::enable_if_t<C>>
+    basic_iterator(const basic_iterator<false>& other) noexcept
+      : owner_(other.owner_), chunk_(other.chunk_), offset_(other.offset_) {}
+
+    reference operator*() const noexcept { return owner_->chunks_[chunk_]->items()[offset_]; }
+    pointer operator->() const noexcept { return &**this; }
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    basic_iterator& operator++() noexcept {
+      if (++offset_ == owner_->chunks_[chunk_]->size) {
+        ++chunk_;
+        offset_ = 0;
+      }
+      return *this;
+    }
+    basic_iterator operator++(int) noexcept { basic_iterator old = *this; ++*this; return old; }
+    basic_iterator& operator--() noexcept {
+      if (offset_ == 0) offset_ = owner_->chunks_[--chunk_]->size;
+      --offset_;
+      return *this;
+    }
+    basic_iterator operator--(int) noexcept { basic_iterator old = *this; --*this; return old; }
+
+    basic_iterator& operator+=(difference_type n) noexcept {
+      return *this = owner_->template iterator_at<Const>(size_type(difference_type(index()) + n));
+    }
+    basic_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+    friend basic_iterator operator+(basic_iterator it, difference_type n) noexcept { return it += n; }
+    friend basic_iterator operator+(difference_type n, basic_iterator it) noexcept { return it += n; }
+    friend basic_iterator operator-(basic_iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) noexcept {
+      return difference_type(a.index()) - difference_type(b.index());
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept {
+      return a.chunk_ == b.chunk_ && a.offset_ == b.offset_;
+    }
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b) noexcept { return !(a == b); }
+    friend bool operator<(const basic_iterator& a, const basic_iterator& b) noexcept {
+      return a.chunk_ < b.chunk_ || (a.chunk_ == b.chunk_ && a.offset_ < b.offset_);
+    }
+    friend bool operator>(const basic_iterator& a, const basic_iterator& b) noexcept { return b < a; }
+    friend bool operator<=(const basic_iterator& a, const basic_iterator& b) noexcept { return !(b < a); }
+    friend bool operator>=(const basic_iterator& a, const basic_iterator& b) noexcept { return !(a < b); }
+
+  private:
+    friend class chunked_vector;
+    friend class basic_iterator<!Const>;
+    basic_iterator(const chunked_vector* owner, std::size_t chunk, std::size_t offset) noexcept
+      : owner_(owner), chunk_(chunk), offset_(offset) {}
+    std::size_t index() const noexcept { return owner_->prefix(chunk_) + offset_; }
+
+    const chunked_vector* owner_ = nullptr;
+    std::size_t chunk_ = 0;    // end() is {chunk_count(), 0}
+    std::size_t offset_ = 0;
+  };
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_type chunk_capacity = ChunkSize;
+
+  // constructors
+  chunked_vector() noexcept = default;
+  explicit chunked_vector(size_type n) { resize(n); }
+  chunked_vector(size_type n, const T& value) { assign(n, value); }
+  template <class InputIt, class = require_iterator<InputIt>>
+  chunked_vector(InputIt first, InputIt last) { assign(first, last); }
+  chunked_vector(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+  chunked_vector(const chunked_vector& other) { assign(other.begin(), other.end()); }
+  chunked_vector(chunked_vector&& other) noexcept { swap(other); }
+
+  ~chunked_vector() { clear(); }
+
+  // operator=
+  chunked_vector& operator=(const chunked_vector& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+  chunked_vector& operator=(chunked_vector&& other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+  chunked_vector& operator=(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+    return *this;
+  }
+
+  // assign()
+  void assign(size_type n, const T& value) {
+    T copy(value);   // value may refer to one of our own elements
+    clear();
+    insert(end(), n, copy);
+  }
+  template <class InputIt, class = require_iterator<InputIt>>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    insert(end(), first, last);
+  }
+  void assign(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+  // element access
+  reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("chunked_vector::at");
+    return (*this)[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("chunked_vector::at");
+    return (*this)[i];
+  }
+  reference operator[](size_type i) noexcept {
+    std::pair<size_type, size_type> at = locate(i);
+    return chunks_[at.first]->items()[at.second];
+  }
+  const_reference operator[](size_type i) const noexcept {
+    std::pair<size_type, size_type> at = locate(i);
+    return chunks_[at.first]->items()[at.second];
+  }
+  reference front() noexcept { return chunks_.front()->items()[0]; }
+  const_reference front() const noexcept { return chunks_.front()->items()[0]; }
+  reference back() noexcept { return chunks_.back()->items()[chunks_.back()->size - 1]; }
+  const_reference back() const noexcept { return chunks_.back()->items()[chunks_.back()->size - 1]; }
+
+  // chunk access: chunk c holds chunk_size(c) contiguous elements starting at chunk_data(c)
+  size_type chunk_count() const noexcept { return chunks_.size(); }
+  T* chunk_data(size_type c) noexcept { return chunks_[c]->items(); }
+  const T* chunk_data(size_type c) const noexcept { return chunks_[c]->items(); }
+  size_type chunk_size(size_type c) const noexcept { return chunks_[c]->size; }
+  template <class Fn>
+  void for_each_chunk(Fn fn) {
+    for (chunk* c : chunks_) fn(c->items(), c->size);
+  }
+  template <class Fn>
+  void for_each_chunk(Fn fn) const {
+    for (chunk* c : chunks_) fn(static_cast<const T*>(c->items()), c->size);
+  }
+
+  // iterators
+  iterator begin() noexcept { return iterator(this, 0, 0); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0, 0); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  iterator end() noexcept { return iterator(this, chunks_.size(), 0); }
+  const_iterator end() const noexcept { return const_iterator(this, chunks_.size(), 0); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type max_size() const noexcept { return std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>()); }
+
+  // modifiers
+  void clear() noexcept {
+    for (chunk* c : chunks_) {
+      destroy(c->items(), c->items() + c->size);
+      delete c;
+    }
+    chunks_.clear();
+    tree_.clear();
+    size_ = 0;
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  iterator insert(const_iterator pos, size_type n, const T& value) {
+    T copy(value);
+    return insert_n(pos.index(), n, [&copy](T* p) { ::new (static_cast<void*>(p)) T(copy); });
+  }
+  template <class InputIt, class = require_iterator<InputIt>>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    if constexpr (is_forward<InputIt>::value) {
+      size_type n = size_type(std::distance(first, last));
+      return insert_n(pos.index(), n, [&first](T* p) { ::new (static_cast<void*>(p)) T(*first); ++first; });
+    } else {
+      std::vector<T> buffer(first, last);
+      auto it = buffer.begin();
+      return insert_n(pos.index(), buffer.size(), [&it](T* p) { ::new (static_cast<void*>(p)) T(std::move(*it)); ++it; });
+    }
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    size_type index = pos.index();
+    if (index == size_) {
+      emplace_back(std::forward<Args>(args)...);
+      return iterator(this, chunks_.size() - 1, chunks_.back()->size - 1);
+    }
+    T value(std::forward<Args>(args)...);   // the arguments may refer to our own elements
+    return insert_at(index, std::move(value));
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, std::next(pos)); }
+  iterator erase(const_iterator first, const_iterator last) {
+    size_type index = first.index();
+    size_type count = last.index() - index;
+    if (count == 0) return iterator_at<false>(index);
+
+    size_type c = first.chunk_;
+    size_type o = first.offset_;
+    const size_type first_chunk = c;
+    size_type remaining = count;
+    while (remaining) {
+      chunk* ch = chunks_[c];
+      size_type m = std::min(remaining, ch->size - o);
+      T* items = ch->items();
+      T* new_end = std::move(items + o + m, items + ch->size, items + o);
+      destroy(new_end, items + ch->size);
+      ch->size -= m;
+      remaining -= m;
+      ++c;
+      o = 0;
+    }
+    size_ -= count;
+
+    if (c == first_chunk + 1 && chunks_[first_chunk]->size != 0 && !needs_merge(first_chunk)) {
+      index_add(first_chunk, -difference_type(count));   // one chunk touched, nothing to restructure
+    } else if (first_chunk + 1 == chunks_.size() && chunks_.back()->size == 0) {
+      delete chunks_.back();   // emptied the last chunk, as pop_back() does
+      chunks_.pop_back();
+      tree_.pop_back();
+    } else {
+      auto is_empty = [](chunk* ch) {
+        if (ch->size != 0) return false;
+        delete ch;
+        return true;
+      };
+      chunks_.erase(std::remove_if(chunks_.begin() + difference_type(first_chunk), chunks_.begin() + difference_type(c), is_empty),
+                    chunks_.begin() + difference_type(c));
+      // the chunks at both ends of the range and the one before; from the right so indices stay valid
+      for (size_type i = std::min(first_chunk + 2, chunks_.size()); i-- > (first_chunk > 0 ? first_chunk - 1 : 0);) merge_if_small(i);
+      rebuild_index();
+    }
+    return iterator_at<false>(index);
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    if (!chunks_.empty() && chunks_.back()->size < ChunkSize) {
+      chunk* last = chunks_.back();
+      T* p = last->items() + last->size;
+      ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+      ++last->size;
+      ++size_;
+      index_add(chunks_.size() - 1, 1);
+      return *p;
+    }
+    room_for_one_more(chunks_);
+    room_for_one_more(tree_);
+    std::unique_ptr<chunk> fresh (new chunk);
+    T* p = fresh->items();
+    ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+    fresh->size = 1;
+    chunks_.push_back(fresh.release());
+    ++size_;
+    append_index();
+    return *p;
+  }
+
+  void pop_back() noexcept {
+    chunk* last = chunks_.back();
+    --last->size;
+    last->items()[last->size].~T();
+    --size_;
+    if (last->size == 0) {
+      delete last;
+      chunks_.pop_back();
+      tree_.pop_back();   // no other Fenwick node covers the last one
+    } else {
+      index_add(chunks_.size() - 1, -1);
+    }
+  }
+
+  void resize(size_type n) {
+    if (n < size_) erase(iterator_at<true>(n), cend());
+    else insert_n(size_, n - size_, [](T* p) { ::new (static_cast<void*>(p)) T(); });
+  }
+  void resize(size_type n, const T& value) {
+    if (n < size_) erase(iterator_at<true>(n), cend());
+    else insert(cend(), n - size_, value);
+  }
+
+  void swap(chunked_vector& other) noexcept {
+    chunks_.swap(other.chunks_);
+    tree_.swap(other.tree_);
+    std::swap(size_, other.size_);
+  }
+
+  // relational operators
+  friend bool operator==(const chunked_vector& lhs, const chunked_vector& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+  friend bool operator!=(const chunked_vector& lhs, const chunked_vector& rhs) { return !(lhs == rhs); }
+  friend bool operator<(const chunked_vector& lhs, const chunked_vector& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  friend bool operator>(const chunked_vector& lhs, const chunked_vector& rhs) { return rhs < lhs; }
+  friend bool operator<=(const chunked_vector& lhs, const chunked_vector& rhs) { return !(rhs < lhs); }
+  friend bool operator>=(const chunked_vector& lhs, const chunked_vector& rhs) { return !(lhs < rhs); }
+
+  friend void swap(chunked_vector& lhs, chunked_vector& rhs) noexcept { lhs.swap(rhs); }
+
+private:
+  static void destroy(T* first, T* last) noexcept { std::destroy(first, last); }
+
+  // so the push_back/insert of one entry that follows cannot throw
+  template <class U>
+  static void room_for_one_more(std::vector<U>& v) {
+    if (v.size() == v.capacity()) v.reserve(std::max<std::size_t>(8, v.capacity() * 2));
+  }
+
+  // move [first, last) into uninitialized storage at out and destroy the originals
+  static void relocate(T* first, T* last, T* out) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if (first != last) std::memmove(static_cast<void*>(out), static_cast<const void*>(first), size_type(last - first) * sizeof(T));
+    } else {
+      std::uninitialized_move(first, last, out);
+      destroy(first, last);
+    }
+  }
+
+  // Fenwick tree over the chunk sizes: tree_[i] (1-based) is the sum of the sizes of the
+  // i & -i chunks ending with chunk i-1; tree_ is empty or holds chunk_count() + 1 entries
+  size_type prefix(size_type c) const noexcept {   // elements in chunks [0, c)
+    if (c == chunks_.size()) return size_;
+    size_type sum = 0;
+    for (; c > 0; c -= c & (0 - c)) sum += tree_[c];
+    return sum;
+  }
+  void index_add(size_type c, difference_type delta) noexcept {
+    for (size_type i = c + 1; i < tree_.size(); i += i & (0 - i)) tree_[i] += size_type(delta);
+  }
+  // chunks_.back() was just appended
+  void append_index() {
+    if (tree_.empty()) tree_.push_back(0);
+    size_type i = chunks_.size();
+    tree_.push_back(size_ - prefix_before(i - (i & (0 - i))));
+  }
+  size_type prefix_before(size_type c) const noexcept {
+    size_type sum = 0;
+    for (; c > 0; c -= c & (0 - c)) sum += tree_[c];
+    return sum;
+  }
+  void rebuild_index() {
+    size_type k = chunks_.size();
+    tree_.assign(k ? k + 1 : 0, 0);
+    size_ = 0;
+    for (size_type i = 1; i <= k; ++i) {
+      size_ += chunks_[i - 1]->size;
+      tree_[i] += chunks_[i - 1]->size;
+      size_type parent = i + (i & (0 - i));
+      if (parent <= k) tree_[parent] += tree_[i];
+    }
+  }
+  // chunk and offset of element i < size()
+  std::pair<size_type, size_type> locate(size_type i) const noexcept {
+    size_type c = 0;
+    size_type k = chunks_.size();
+    size_type step = 1;
+    while (step * 2 <= k) step *= 2;
+    for (; step; step /= 2) {
+      if (c + step <= k && tree_[c + step] <= i) {
+        c += step;
+        i -= tree_[c];
+      }
+    }
+    return {c, i};
+  }
+  template <bool Const>
+  basic_iterator<Const> iterator_at(size_type i) const noexcept {
+    if (i >= size_) return basic_iterator<Const>(this, chunks_.size(), 0);
+    std::pair<size_type, size_type> at = locate(i);
+    return basic_iterator<Const>(this, at.first, at.second);
+  }
+
+  // move the elements [offset, size) of chunk c to a new chunk right after it; the caller rebuilds the index
+  void split(size_type c, size_type offset) {
+    room_for_one_more(chunks_);
+    chunk* from = chunks_[c];
+    chunk* to = new chunk;
+    relocate(from->items() + offset, from->items() + from->size, to->items());
+    to->size = from->size - offset;
+    from->size = offset;
+    chunks_.insert(chunks_.begin() + difference_type(c) + 1, to);
+  }
+
+  // a chunk below a quarter full is folded into a neighbour with room for it
+  bool merges_right(size_type c) const noexcept {
+    return c + 1 < chunks_.size() && chunks_[c]->size + chunks_[c + 1]->size <= ChunkSize;
+  }
+  bool merges_left(size_type c) const noexcept {
+    return c > 0 && chunks_[c - 1]->size + chunks_[c]->size <= ChunkSize;
+  }
+  bool needs_merge(size_type c) const noexcept {
+    return chunks_[c]->size < ChunkSize / 4 && (merges_right(c) || merges_left(c));
+  }
+
+  // the caller rebuilds the index
+  void merge_if_small(size_type c) {
+    if (!needs_merge(c)) return;
+    size_type left = merges_right(c) ? c : c - 1;
+    chunk* a = chunks_[left];
+    chunk* b = chunks_[left + 1];
+    relocate(b->items(), b->items() + b->size, a->items() + a->size);
+    a->size += b->size;
+    delete b;
+    chunks_.erase(chunks_.begin() + difference_type(left) + 1);
+  }
+
+  // insert value before element index < size()
+  iterator insert_at(size_type index, T&& value) {
+    std::pair<size_type, size_type> at = locate(index);
+    size_type c = at.first;
+    size_type o = at.second;
+    if (o == 0 && c > 0 && chunks_[c - 1]->size < ChunkSize) {
+      // at the start of a chunk: append to the previous one if it has room, nothing to shift
+      chunk* prev = chunks_[c - 1];
+      ::new (static_cast<void*>(prev->items() + prev->size)) T(std::move(value));
+      ++prev->size;
+      ++size_;
+      index_add(c - 1, 1);
+      return iterator(this, c - 1, prev->size - 1);
+    }
+    if (chunks_[c]->size == ChunkSize) {
+      size_type half = ChunkSize / 2;
+      split(c, half);
+      rebuild_index();
+      if (o >= half) {
+        ++c;
+        o -= half;
+      }
+    }
+    chunk* ch = chunks_[c];
+    T* items = ch->items();
+    ::new (static_cast<void*>(items + ch->size)) T(std::move(items[ch->size - 1]));
+    std::move_backward(items + o, items + ch->size - 1, items + ch->size);
+    items[o] = std::move(value);
+    ++ch->size;
+    ++size_;
+    index_add(c, 1);
+    return iterator(this, c, o);
+  }
+
+  // insert count elements before element index (<= size()), make(p) constructs one at p
+  template <class Make>
+  iterator insert_n(size_type index, size_type count, Make make) {
+    if (count == 0) return iterator_at<false>(index);
+    if (index == size_) {
+      append_n(count, make);
+      return iterator_at<false>(index);
+    }
+    std::pair<size_type, size_type> pos = locate(index);
+    size_type c = pos.first;
+    size_type o = pos.second;
+    if (o == 0 && c > 0 && chunks_[c - 1]->size + count <= ChunkSize) {
+      // at the start of a chunk: append to the previous one if it has room, nothing to shift
+      size_type end = chunks_[c - 1]->size;
+      fill_at(c - 1, end, count, make);
+      return iterator(this, c - 1, end);
+    }
+    if (chunks_[c]->size + count > ChunkSize && count <= ChunkSize / 2) {
+      // no room: split at the midpoint as insert_at does, both halves then have room for count
+      size_type half = chunks_[c]->size / 2;
+      split(c, half);
+      rebuild_index();
+      if (o > half) {
+        ++c;
+        o -= half;
+      }
+    }
+    if (chunks_[c]->size + count <= ChunkSize) {
+      fill_at(c, o, count, make);
+      return iterator(this, c, o);
+    }
+    return insert_chunks(c, o, count, make);
+  }
+
+  // count elements into chunk c before offset o, which has room for them; make runs in order
+  template <class Make>
+  void fill_at(size_type c, size_type o, size_type count, Make& make) {
+    chunk* ch = chunks_[c];
+    T* items = ch->items();
+    size_type done = 0;
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      // open the gap first, close it again if make throws
+      std::memmove(static_cast<void*>(items + o + count), static_cast<const void*>(items + o), (ch->size - o) * sizeof(T));
+      try {
+        for (; done < count; ++done) make(items + o + done);
+      } catch (...) {
+        std::memmove(static_cast<void*>(items + o), static_cast<const void*>(items + o + count), (ch->size - o) * sizeof(T));
+        throw;
+      }
+    } else {
+      // construct behind the last element, then rotate into place
+      try {
+        for (; done < count; ++done) make(items + ch->size + done);
+      } catch (...) {
+        destroy(items + ch->size, items + ch->size + done);
+        throw;
+      }
+      std::rotate(items + o, items + ch->size, items + ch->size + count);
+    }
+    ch->size += count;
+    size_ += count;
+    index_add(c, difference_type(count));
+  }
+
+  // at the end: fill the last chunk, then append full chunks
+  template <class Make>
+  void append_n(size_type count, Make& make) {
+    if (!chunks_.empty()) {
+      chunk* last = chunks_.back();
+      size_type before = last->size;
+      auto account = [&] {
+        size_ += last->size - before;
+        index_add(chunks_.size() - 1, difference_type(last->size - before));
+      };
+      try {
+        for (; count && last->size < ChunkSize; --count, ++last->size) make(last->items() + last->size);
+      } catch (...) {
+        account();
+        throw;
+      }
+      account();
+    }
+    while (count) {
+      room_for_one_more(chunks_);
+      room_for_one_more(tree_);
+      room_for_one_more(tree_);   // the first chunk adds two entries
+      std::unique_ptr<chunk> fresh (new chunk);
+      try {
+        for (; count && fresh->size < ChunkSize; --count, ++fresh->size) make(fresh->items() + fresh->size);
+      } catch (...) {
+        destroy(fresh->items(), fresh->items() + fresh->size);
+        throw;
+      }
+      size_ += fresh->size;
+      chunks_.push_back(fresh.release());
+      append_index();
+    }
+  }
+
+  // more than a chunk can take: split chunk c at o, fill its front part, put the rest in new chunks
+  // and merge whatever ended up below a quarter full
+  template <class Make>
+  iterator insert_chunks(size_type c, size_type o, size_type count, Make& make) {
+    const size_type index = prefix(c) + o;
+    size_type at = c;   // where the new chunks go
+    if (o > 0) {
+      split(c, o);
+      at = c + 1;
+    }
+    std::vector<chunk*> fresh;
+    fresh.reserve(count / ChunkSize + 1);
+    try {
+      if (at > 0) {
+        chunk* prev = chunks_[at - 1];
+        for (; count && prev->size < ChunkSize; --count, ++prev->size) make(prev->items() + prev->size);
+      }
+      while (count) {
+        fresh.push_back(new chunk);
+        chunk* ch = fresh.back();
+        for (; count && ch->size < ChunkSize; --count, ++ch->size) make(ch->items() + ch->size);
+      }
+      chunks_.insert(chunks_.begin() + difference_type(at), fresh.begin(), fresh.end());
+    } catch (...) {
+      for (chunk* ch : fresh) {
+        destroy(ch->items(), ch->items() + ch->size);
+        delete ch;
+      }
+      rebuild_index();
+      throw;
+    }
+    // the last new chunk and the split-off tail can be small; from the right so indices stay valid
+    for (size_type i = std::min(at + fresh.size() + 1, chunks_.size()); i-- > (at > 0 ? at - 1 : 0);) merge_if_small(i);
+    rebuild_index();
+    return iterator_at<false>(index);
+  }
+
+  std::vector<chunk*> chunks_;   // never holds an empty chunk
+  std::vector<size_type> tree_;
+  size_type size_ = 0;
+};
+
+#endif /* chunked_vector_hpp */
@@ -0,0 +1,308 @@
+//
+//  compressed_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// compressed_vector<T> holds 32-bit ints (int or std::uint32_t) in blocks of 128, each block stored as
+// a reference value plus bit-packed offsets, so small and sorted values take a few bits each instead
+// of 32 and a scan reads that much less memory. Each block picks one codec:
+// - frame of reference : value - min of the block, packed as wide as max - min needs
+//                        (assign(7,100): 0 bits; values 1..10: 4 bits)
+// - delta              : the differences between neighbours, minus the smallest one, packed
+//                        (sorted IDs with gaps under 256: 8 bits at most, whatever their magnitude)
+// int_codec::automatic (the default) takes the narrower of the two per block; the constructor can
+// force one. The last, partial block is kept unpacked and is encoded when it fills, so push_back is
+// O(1) and every 128th call packs a block.
+// - push_back, append, at, [], front, back, size, clear, shrink_to_fit, ==, !=
+// - begin/end   : input iterators that decode a whole block at a time with simd::unpack_*
+// - for_each_block(f) : f(const T* values, std::size_t count) once per decoded block, the fastest scan
+// - compressed_bytes(), compression_ratio() : memory used, and plain bytes / memory used
+//
+// How?
+// - compressed_vector<int> ids;  for (int id : sorted_ids) ids.push_back(id);
+// - std::int64_t s = 0;  ids.for_each_block([&](const int* p, std::size_t n) { s += simd::sum(p, n); });
+// at(i) costs a shift and a mask in a frame-of-reference block, and the decode of the whole block in
+// a delta block. Elements are values, not objects: [] returns T and there is no data().
+// simd_kernels.cpp has to be built in.
+
+#ifndef compressed_vector_hpp
+#define compressed_vector_hpp
+
+#include "simd_kernels.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+enum class int_codec { automatic, frame_of_reference, delta };
+
+namespace compressed_detail {
+
+constexpr std::size_t block_size = 128;
+
+struct block {
+  std::uint64_t offset;   // first word in words_
+  std::uint32_t base;     // frame of reference: the minimum; delta: first value - step
+  std::uint32_t step;     // delta: the smallest difference; frame of reference: 0
+  std::uint8_t bits;      // packed width, 0..32; the block has 4 * bits words
+  bool delta;
+};
+
+inline unsigned bits_for(std::uint32_t range) noexcept { return range ? 32u - unsigned(__builtin_clz(range)) : 0u; }
+
+// value j of a packed block, in the layout of simd::kernels::unpack_for
+inline std::uint32_t unpacked(const std::uint32_t* in, unsigned bits, std::size_t j) noexcept {
+  if (!bits) return 0;
+  std::size_t bit = (j / 4) * bits;
+  const std::uint32_t* word = in + (bit / 32) * 4 + j % 4;
+  std::uint64_t pair = word[0];
+  if (bit % 32 + bits > 32) pair |= std::uint64_t(word[4]) << 32;
+  return std::uint32_t(pair >> (bit % 32)) & (bits == 32 ? ~0u : (1u << bits) - 1);
+}
+
+inline void pack(const std::uint32_t* offsets, unsigned bits, std::uint32_t* out) noexcept {
+  for (std::size_t j = 0; bits && j < block_size; ++j)
+  {
+    std::size_t bit = (j / 4) * bits;
+    std::uint32_t* word = out + (bit / 32) * 4 + j % 4;
+    unsigned shift = unsigned(bit % 32);
+    word[0] |= offsets[j] << shift;
+    if (shift + bits > 32) word[4] |= offsets[j] >> (32 - shift);
+  }
+}
+
+} // namespace compressed_detail
+
+template <class T = int>
+class compressed_vector {
+  static_assert(std::is_integral<T>::value && sizeof(T) == 4, "compressed_vector holds 32-bit ints");
+
+  using block = compressed_detail::block;
+  static constexpr std::size_t block_size = compressed_detail::block_size;
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T;
+  using const_reference = T;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() noexcept = default;
+    const_iterator(const compressed_vector* owner, size_type i) noexcept : owner_(owner), i_(i) {}
+
+    // decodes the block of i on first use; the reference stays valid until the iterator moves to the next block
+    reference operator*() const {
+      if (i_ / block_size != loaded_)
+      {
+        loaded_ = i_ / block_size;
+        owner_->decode_block(loaded_, values_.data());
+      }
+      return values_[i_ % block_size];
+    }
+    pointer operator->() const { return &**this; }
+    const_iterator& operator++() noexcept { ++i_; return *this; }
+    const_iterator operator++(int) { const_iterator t = *this; ++i_; return t; }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ == b.i_; }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ != b.i_; }
+
+  private:
+    const compressed_vector* owner_ = nullptr;
+    size_type i_ = 0;
+    mutable size_type loaded_ = size_type(-1);
+    mutable std::array<T, block_size> values_;
+  };
+  using iterator = const_iterator;
+
+  explicit compressed_vector(int_codec codec = int_codec::automatic) noexcept : codec_(codec) {}
+  compressed_vector(std::initializer_list<T> init, int_codec codec = int_codec::automatic) : codec_(codec) {
+    append(init.begin(), init.end());
+  }
+  template <class It, class = typename std::iterator_traits<It>::iterator_category>
+  compressed_vector(It first, It last, int_codec codec = int_codec::automatic) : codec_(codec) {
+    append(first, last);
+  }
+
+  // element access
+  T operator[](size_type i) const noexcept {
+    size_type b = i / block_size, j = i % block_size;
+    if (b == blocks_.size()) return T(tail_[j]);
+    const block& k = blocks_[b];
+    const std::uint32_t* in = words_.data() + k.offset;
+    if (!k.delta) return T(k.base + compressed_detail::unpacked(in, k.bits, j));
+    // a running sum: decoding the whole block with simd beats adding up to 128 values one by one
+    alignas(64) std::uint32_t values[block_size];
+    simd::unpack_delta(in, k.bits, k.base, k.step, values);
+    return T(values[j]);
+  }
+  T at(size_type i) const {
+    if (i >= size()) throw std::out_of_range("compressed_vector::at");
+    return (*this)[i];
+  }
+  T front() const noexcept { return (*this)[0]; }
+  T back() const noexcept { return (*this)[size() - 1]; }
+
+  // iterators
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator cbegin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size()}; }
+  const_iterator cend() const noexcept { return {this, size()}; }
+
+  // capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return blocks_.size() * block_size + tail_size_; }
+  int_codec codec() const noexcept { return codec_; }
+  size_type block_count() const noexcept { return blocks_.size() + (tail_size_ ? 1 : 0); }
+  // the packed words, the block headers and the unpacked last block
+  size_type compressed_bytes() const noexcept {
+    return words_.size() * sizeof(std::uint32_t) + blocks_.size() * sizeof(block) + tail_size_ * sizeof(T);
+  }
+  // bytes as a plain vector / compressed_bytes(); 1 when empty
+  double compression_ratio() const noexcept {
+    return compressed_bytes() ? double(size() * sizeof(T)) / double(compressed_bytes()) : 1.0;
+  }
+  void shrink_to_fit() {
+    words_.shrink_to_fit();
+    blocks_.shrink_to_fit();
+  }
+
+  // modifiers
+  void push_back(T value) {
+    tail_[tail_size_++] = std::uint32_t(value);
+    if (tail_size_ == block_size)
+    {
+      try
+      {
+        encode_tail();
+      }
+      catch (...)
+      {
+        --tail_size_;
+        throw;
+      }
+    }
+  }
+  template <class It, class = typename std::iterator_traits<It>::iterator_category>
+  void append(It first, It last) {
+    for (; first != last; ++first) push_back(T(*first));
+  }
+  void clear() noexcept {
+    blocks_.clear();
+    words_.clear();
+    tail_size_ = 0;
+  }
+  void swap(compressed_vector& other) noexcept {
+    std::swap(codec_, other.codec_);
+    blocks_.swap(other.blocks_);
+    words_.swap(other.words_);
+    std::swap(tail_, other.tail_);
+    std::swap(tail_size_, other.tail_size_);
+  }
+  friend void swap(compressed_vector& a, compressed_vector& b) noexcept { a.swap(b); }
+
+  // decoding
+  // the values of block b (block_size of them, fewer for the last block) into out
+  size_type decode_block(size_type b, T* out) const noexcept {
+    std::uint32_t* dst = reinterpret_cast<std::uint32_t*>(out);
+    if (b == blocks_.size())
+    {
+      std::memcpy(dst, tail_.data(), tail_size_ * sizeof(T));
+      return tail_size_;
+    }
+    const block& k = blocks_[b];
+    if (k.delta) simd::unpack_delta(words_.data() + k.offset, k.bits, k.base, k.step, dst);
+    else simd::unpack_for(words_.data() + k.offset, k.bits, k.base, dst);
+    return block_size;
+  }
+  template <class F>
+  void for_each_block(F&& f) const {
+    alignas(64) T values[block_size];
+    for (size_type b = 0; b < block_count(); ++b) f(static_cast<const T*>(values), decode_block(b, values));
+  }
+  std::vector<T> to_vector() const {
+    std::vector<T> out(size() + block_size);   // room for a whole last block
+    for (size_type b = 0; b < block_count(); ++b) decode_block(b, out.data() + b * block_size);
+    out.resize(size());
+    return out;
+  }
+
+  friend bool operator==(const compressed_vector& a, const compressed_vector& b) {
+    if (a.size() != b.size()) return false;
+    alignas(64) T x[block_size], y[block_size];
+    for (size_type k = 0; k < a.block_count(); ++k)
+    {
+      size_type n = a.decode_block(k, x);
+      b.decode_block(k, y);
+      if (std::memcmp(x, y, n * sizeof(T)) != 0) return false;
+    }
+    return true;
+  }
+  friend bool operator!=(const compressed_vector& a, const compressed_vector& b) { return !(a == b); }
+
+private:
+  // packs the full tail as a new block with the codec of this vector (the narrower one if automatic)
+  void encode_tail() {
+    // frame of reference, ordered as T
+    const std::uint32_t flip = std::is_signed<T>::value ? 0x80000000u : 0;
+    std::uint32_t lo = tail_[0] ^ flip, hi = lo;
+    // delta, with signed differences so small steps down stay small
+    std::int64_t dlo = INT64_MAX, dhi = INT64_MIN;
+    for (size_type j = 1; j < block_size; ++j)
+    {
+      std::uint32_t key = tail_[j] ^ flip;
+      lo = key < lo ? key : lo;
+      hi = key > hi ? key : hi;
+      std::int64_t d = std::int32_t(tail_[j] - tail_[j - 1]);
+      dlo = d < dlo ? d : dlo;
+      dhi = d > dhi ? d : dhi;
+    }
+    unsigned for_bits = compressed_detail::bits_for(hi - lo);
+    unsigned delta_bits = compressed_detail::bits_for(std::uint32_t(dhi - dlo));
+    bool delta = codec_ == int_codec::delta || (codec_ == int_codec::automatic && delta_bits < for_bits);
+
+    block k;
+    k.offset = words_.size();
+    k.delta = delta;
+    k.bits = std::uint8_t(delta ? delta_bits : for_bits);
+    k.step = delta ? std::uint32_t(dlo) : 0;
+    k.base = delta ? tail_[0] - k.step : lo ^ flip;
+    std::uint32_t offsets[block_size];
+    offsets[0] = delta ? 0 : tail_[0] - k.base;
+    for (size_type j = 1; j < block_size; ++j) offsets[j] = delta ? tail_[j] - tail_[j - 1] - k.step : tail_[j] - k.base;
+
+    words_.resize(words_.size() + 4 * k.bits, 0);
+    compressed_detail::pack(offsets, k.bits, words_.data() + k.offset);
+    try
+    {
+      blocks_.push_back(k);
+    }
+    catch (...)
+    {
+      words_.resize(k.offset);
+      throw;
+    }
+    tail_size_ = 0;
+  }
+
+  int_codec codec_;
+  std::vector<block> blocks_;
+  std::vector<std::uint32_t> words_;
+  std::array<std::uint32_t, block_size> tail_;
+  size_type tail_size_ = 0;
+};
+
+#endif /* compressed_vector_hpp */
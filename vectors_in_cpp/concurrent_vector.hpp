@@ -0,0 +1,316 @@
+//
+//  concurrent_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// concurrent_vector<T> is a growable vector many threads can push_back()/emplace_back() to at once
+// without a lock, while others read the elements already completed
+// - lock-free appends: one fetch_add claims a slot; the segments are allocated one ahead of need, and
+//   if a slot's segment is missing anyway, by whichever thread gets there first (a compare-exchange,
+//   the losers free theirs)
+// - segmented storage: segment k holds FirstSegment << k elements and never moves, so the address of
+//   an element (and any reference to it) stays valid until the vector is destroyed or cleared
+// - size() is the completed prefix: every element below it is fully constructed and safe to read from
+//   any thread, even while appends continue behind it
+//
+// How?
+// - concurrent_vector<record> log;
+//   // any number of threads:
+//   record& r = log.emplace_back(id, payload);   // r stays valid while others keep appending
+//   // any thread:
+//   for (std::size_t i = 0, n = log.size(); i < n; ++i) use(log[i]);
+// Elements are never removed one at a time: clear(), reserve(), swap(), copying and destruction need
+// the vector to themselves. Iterators and for-loops cover the elements completed when end() was called.
+//
+// A thread that finishes its element publishes it by setting the slot's ready flag and then moving
+// size() forward over every ready slot it finds, so a slot completed early becomes visible as soon as
+// the slots before it are done. An element whose constructor may throw is built before a slot is
+// claimed and then moved in, so a failed constructor leaves no hole; a failed segment allocation does,
+// and size() never passes that slot.
+
+#ifndef concurrent_vector_hpp
+#define concurrent_vector_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <class T, std::size_t FirstSegment = 64>
+class concurrent_vector {
+  static_assert(FirstSegment > 0 && (FirstSegment & (FirstSegment - 1)) == 0,
+                "concurrent_vector segments are powers of two");
+  static_assert(std::is_nothrow_destructible<T>::value, "concurrent_vector elements must not throw on destruction");
+
+  static constexpr unsigned first_bits = unsigned(__builtin_ctzll(FirstSegment));
+  static constexpr unsigned max_segments = 64 - first_bits;
+
+  // a segment: the ready flags, then the elements
+  struct segment {
+    std::size_t capacity;
+    std::atomic<bool>* ready;
+    T* items;
+  };
+
+  template <bool Const>
+  class basic_iterator {
+    using owner_type = std::conditional_t<Const, const concurrent_vector, concurrent_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    basic_iterator() noexcept = default;
+    basic_iterator(owner_type* owner, std::size_t i) noexcept : owner_(owner), i_(i) {}
+    operator basic_iterator<true>() const noexcept { return {owner_, i_}; }
+
+    reference operator*() const noexcept { return (*owner_)[i_]; }
+    pointer operator->() const noexcept { return &(*owner_)[i_]; }
+    reference operator[](difference_type d) const noexcept { return (*owner_)[i_ + std::size_t(d)]; }
+
+    basic_iterator& operator++() noexcept { ++i_; return *this; }
+    basic_iterator operator++(int) noexcept { basic_iterator t = *this; ++i_; return t; }
+    basic_iterator& operator--() noexcept { --i_; return *this; }
+    basic_iterator operator--(int) noexcept { basic_iterator t = *this; --i_; return t; }
+    basic_iterator& operator+=(difference_type d) noexcept { i_ += std::size_t(d); return *this; }
+    basic_iterator& operator-=(difference_type d) noexcept { i_ -= std::size_t(d); return *this; }
+    friend basic_iterator operator+(basic_iterator it, difference_type d) noexcept { return it += d; }
+    friend basic_iterator operator+(difference_type d, basic_iterator it) noexcept { return it += d; }
+    friend basic_iterator operator-(basic_iterator it, difference_type d) noexcept { return it -= d; }
+    friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) noexcept {
+      return difference_type(a.i_) - difference_type(b.i_);
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ == b.i_; }
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ != b.i_; }
+    friend bool operator<(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ < b.i_; }
+    friend bool operator>(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ > b.i_; }
+    friend bool operator<=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ <= b.i_; }
+    friend bool operator>=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ >= b.i_; }
+
+  private:
+    owner_type* owner_ = nullptr;
+    std::size_t i_ = 0;
+  };
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  concurrent_vector() noexcept = default;
+  concurrent_vector(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const T& x : init) push_back(x);
+  }
+  concurrent_vector(const concurrent_vector& other) {
+    reserve(other.size());
+    for (const T& x : other) push_back(x);
+  }
+  concurrent_vector(concurrent_vector&& other) noexcept { swap(other); }
+  ~concurrent_vector() {
+    clear();
+    for (auto& s : segments_) free_segment(s.exchange(nullptr, std::memory_order_relaxed));
+  }
+
+  concurrent_vector& operator=(const concurrent_vector& other) {
+    if (this != &other) concurrent_vector(other).swap(*this);
+    return *this;
+  }
+  concurrent_vector& operator=(concurrent_vector&& other) noexcept {
+    concurrent_vector(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  // appends, safe from any number of threads at once
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    if constexpr (std::is_nothrow_constructible<T, Args...>::value) {
+      std::size_t i = claimed_.fetch_add(1, std::memory_order_relaxed);
+      T* p = slot(i);
+      ::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+      publish(i);
+      return *p;
+    } else {
+      static_assert(std::is_nothrow_move_constructible<T>::value,
+                    "concurrent_vector needs a noexcept constructor or a noexcept move constructor");
+      T value(std::forward<Args>(args)...);
+      std::size_t i = claimed_.fetch_add(1, std::memory_order_relaxed);
+      T* p = slot(i);
+      ::new (static_cast<void*>(p)) T(std::move(value));
+      publish(i);
+      return *p;
+    }
+  }
+
+  // element access, for i < size()
+  reference operator[](size_type i) noexcept { return *locate(i); }
+  const_reference operator[](size_type i) const noexcept { return *locate(i); }
+  reference at(size_type i) {
+    if (i >= size()) throw std::out_of_range("concurrent_vector::at");
+    return *locate(i);
+  }
+  const_reference at(size_type i) const {
+    if (i >= size()) throw std::out_of_range("concurrent_vector::at");
+    return *locate(i);
+  }
+  reference front() noexcept { return *locate(0); }
+  const_reference front() const noexcept { return *locate(0); }
+  reference back() noexcept { return *locate(size() - 1); }
+  const_reference back() const noexcept { return *locate(size() - 1); }
+
+  // iterators
+  iterator begin() noexcept { return {this, 0}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator cbegin() const noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size()}; }
+  const_iterator end() const noexcept { return {this, size()}; }
+  const_iterator cend() const noexcept { return {this, size()}; }
+
+  // capacity
+  // completed elements; appends in progress are not counted until every slot before them is done
+  size_type size() const noexcept { return published_.load(std::memory_order_acquire); }
+  bool empty() const noexcept { return size() == 0; }
+  size_type capacity() const noexcept {
+    size_type n = 0;
+    for (unsigned k = 0; k < max_segments; ++k)
+      if (segments_[k].load(std::memory_order_acquire)) n += segment_capacity(k);
+    return n;
+  }
+  static constexpr size_type segment_capacity(unsigned k) noexcept { return FirstSegment << k; }
+
+  // allocates the segments for n elements up front, so appends below n never allocate
+  void reserve(size_type n) {
+    if (n == 0) return;
+    for (unsigned k = 0, last = segment_of(n - 1); k <= last; ++k) segment_for(k);
+  }
+
+  // not concurrent: destroys the elements, keeps the segments
+  void clear() noexcept {
+    size_type n = claimed_.load(std::memory_order_relaxed);
+    for (size_type i = 0; i < n; ++i)
+    {
+      if (!is_ready(i)) continue;
+      locate(i)->~T();
+      ready_flag(i).store(false, std::memory_order_relaxed);
+    }
+    claimed_.store(0, std::memory_order_relaxed);
+    published_.store(0, std::memory_order_relaxed);
+  }
+
+  // not concurrent
+  void swap(concurrent_vector& other) noexcept {
+    for (unsigned k = 0; k < max_segments; ++k)
+    {
+      segment* s = segments_[k].load(std::memory_order_relaxed);
+      segments_[k].store(other.segments_[k].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      other.segments_[k].store(s, std::memory_order_relaxed);
+    }
+    size_type c = claimed_.load(std::memory_order_relaxed);
+    claimed_.store(other.claimed_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    other.claimed_.store(c, std::memory_order_relaxed);
+    size_type p = published_.load(std::memory_order_relaxed);
+    published_.store(other.published_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    other.published_.store(p, std::memory_order_relaxed);
+  }
+  friend void swap(concurrent_vector& a, concurrent_vector& b) noexcept { a.swap(b); }
+
+private:
+  // element i lives in segment k = floor(log2(i + FirstSegment)) - first_bits
+  static unsigned segment_of(size_type i) noexcept {
+    return unsigned(63 - __builtin_clzll(std::uint64_t(i + FirstSegment))) - first_bits;
+  }
+  static size_type offset_in(size_type i, unsigned k) noexcept { return i + FirstSegment - segment_capacity(k); }
+
+  T* locate(size_type i) const noexcept {
+    unsigned k = segment_of(i);
+    return segments_[k].load(std::memory_order_acquire)->items + offset_in(i, k);
+  }
+
+  std::atomic<bool>& ready_flag(size_type i) const noexcept {
+    unsigned k = segment_of(i);
+    return segments_[k].load(std::memory_order_acquire)->ready[offset_in(i, k)];
+  }
+
+  T* slot(size_type i) {
+    unsigned k = segment_of(i);
+    if (k >= max_segments) throw std::length_error("concurrent_vector");
+    T* p = segment_for(k)->items + offset_in(i, k);
+    // the first append to a segment allocates the next one, so that the threads reaching it later
+    // seldom race to allocate (and all but one free) a segment of their own; best effort only
+    if (offset_in(i, k) == 0 && k + 1 < max_segments)
+      try { segment_for(k + 1); }
+      catch (const std::bad_alloc&) {}
+    return p;
+  }
+
+  segment* segment_for(unsigned k) {
+    segment* s = segments_[k].load(std::memory_order_acquire);
+    if (s) return s;
+    segment* fresh = allocate_segment(segment_capacity(k));
+    if (segments_[k].compare_exchange_strong(s, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+      return fresh;
+    free_segment(fresh);   // another thread installed it first
+    return s;
+  }
+
+  // size() moves over a slot only after its ready flag was seen; both sides are seq_cst so that of a
+  // thread setting its flag and a thread stopping short of it, at least one sees the other
+  void publish(size_type i) noexcept {
+    ready_flag(i).store(true, std::memory_order_seq_cst);
+    size_type p = published_.load(std::memory_order_seq_cst);
+    while (is_ready(p))
+      if (published_.compare_exchange_weak(p, p + 1, std::memory_order_seq_cst)) ++p;
+  }
+
+  // false for slots whose segment is not there yet, claimed or not
+  bool is_ready(size_type i) const noexcept {
+    unsigned k = segment_of(i);
+    if (k >= max_segments) return false;
+    segment* s = segments_[k].load(std::memory_order_acquire);
+    return s && s->ready[offset_in(i, k)].load(std::memory_order_seq_cst);
+  }
+
+  static segment* allocate_segment(size_type capacity) {
+    constexpr std::size_t align = std::max(alignof(T), alignof(segment));
+    std::size_t flags_at = (sizeof(segment) + alignof(std::atomic<bool>) - 1) / alignof(std::atomic<bool>)
+                           * alignof(std::atomic<bool>);
+    std::size_t items_at = (flags_at + capacity * sizeof(std::atomic<bool>) + alignof(T) - 1) / alignof(T) * alignof(T);
+    char* raw = static_cast<char*>(::operator new(items_at + capacity * sizeof(T), std::align_val_t(align)));
+    auto* flags = reinterpret_cast<std::atomic<bool>*>(raw + flags_at);
+    for (size_type i = 0; i < capacity; ++i) ::new (static_cast<void*>(flags + i)) std::atomic<bool>(false);
+    return ::new (static_cast<void*>(raw)) segment{capacity, flags, reinterpret_cast<T*>(raw + items_at)};
+  }
+
+  static void free_segment(segment* s) noexcept {
+    if (!s) return;
+    constexpr std::size_t align = std::max(alignof(T), alignof(segment));
+    ::operator delete(static_cast<void*>(s), std::align_val_t(align));
+  }
+
+  std::atomic<segment*> segments_[max_segments] = {};
+  // claimed_ and published_ are written by every append, keep them off the segment table's cache line
+  alignas(64) std::atomic<size_type> claimed_ {0};
+  alignas(64) std::atomic<size_type> published_ {0};
+};
+
+#endif /* concurrent_vector_hpp */
@@ -0,0 +1,268 @@
+//
+//  demo_report.hpp
+//  vectors_in_cpp
+//
+// What?
+// Per-section measurements for the demos in main.cpp
+// demo_sections records how long each section ("assign", "at", "back" ...) took and, when the vectors
+// allocate through a counting_resource, how many allocations it made and its peak bytes
+//
+// How?
+// - main.cpp marks each section with sections.begin("name"); the next begin() (or end()) closes it
+// - run_demo_tool() runs the demos once with normal output and, with --report, again
+//   --repeat times with std::cout muted, then prints a table with the best time per section
+// Options:
+//  --report              print the per-section table
+//  --repeat=<n>          runs per resource for the report (default 200)
+//  --resource=<name>     pmr builds only: new_delete, arena or pool for the normal run
+//  --trace=<file>        tracing builds only: write the timeline of the normal run (Chrome trace format)
+
+#ifndef demo_report_hpp
+#define demo_report_hpp
+
+#include "arena.hpp"
+#include "demo_vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+class demo_sections {
+public:
+  struct section {
+    std::string name;
+    double ns = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes_allocated = 0;
+    std::uint64_t peak_bytes = 0;    // above what was live when the section started
+  };
+
+  explicit demo_sections(counting_resource* counter = nullptr) : counter_(counter) {}
+
+  void begin(const char* name) {
+    end();
+    open_ = true;
+    current_ = section();
+    current_.name = name;
+    if (counter_)
+    {
+      counter_->reset_peak();
+      stats_begin_ = counter_->stats();
+    }
+#if defined(DEMO_VECTOR_USES_TRACING)
+    trace_log::instance().begin_section(name);
+#endif
+    start_ = clock::now();
+  }
+
+  void end() {
+    if (!open_) return;
+    auto stop = clock::now();
+    current_.ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start_).count());
+    if (counter_)
+    {
+      const resource_stats& s = counter_->stats();
+      current_.allocations = s.allocations - stats_begin_.allocations;
+      current_.bytes_allocated = s.bytes_allocated - stats_begin_.bytes_allocated;
+      current_.peak_bytes = s.peak_bytes - stats_begin_.live_bytes;
+    }
+#if defined(DEMO_VECTOR_USES_TRACING)
+    trace_log::instance().end_section();
+#endif
+    sections_.push_back(current_);
+    open_ = false;
+  }
+
+  const std::vector<section>& sections() const { return sections_; }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  counting_resource* counter_;
+  std::vector<section> sections_;
+  section current_;
+  resource_stats stats_begin_;
+  clock::time_point start_;
+  bool open_ = false;
+};
+
+using demo_fn = void (*)(demo_sections&);
+
+namespace demo_detail {
+
+// swallows everything written to it, used to mute std::cout during the report runs
+class null_buffer : public std::streambuf {
+protected:
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct resource_run {
+  std::string resource;
+  std::vector<demo_sections::section> best;
+};
+
+// run the demos `repeat` times on the named resource and keep the fastest time of every section
+inline resource_run measure(demo_fn demos, const char* resource, int repeat) {
+  resource_run run;
+  run.resource = resource;
+  null_buffer null;
+  std::streambuf* out = std::cout.rdbuf(&null);
+#if defined(DEMO_VECTOR_USES_TRACING)
+  trace_log::instance().enable(false);
+#endif
+  for (int r = 0; r < repeat; ++r)
+  {
+#if defined(DEMO_VECTOR_USES_PMR)
+    arena_resource arena;
+    std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+    if (std::strcmp(resource, "arena") == 0) upstream = &arena;
+    else if (std::strcmp(resource, "pool") == 0) upstream = thread_local_pool();
+    counting_resource counter (upstream);
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&counter);
+    demo_sections sections (&counter);
+    demos(sections);
+    sections.end();
+    std::pmr::set_default_resource(previous);
+#else
+    demo_sections sections;
+    demos(sections);
+    sections.end();
+#endif
+    if (r == 0)
+    {
+      run.best = sections.sections();
+      continue;
+    }
+    for (std::size_t i = 0; i < run.best.size() && i < sections.sections().size(); ++i)
+      if (sections.sections()[i].ns < run.best[i].ns) run.best[i].ns = sections.sections()[i].ns;
+  }
+  std::cout.rdbuf(out);
+#if defined(DEMO_VECTOR_USES_TRACING)
+  trace_log::instance().enable(true);
+#endif
+  return run;
+}
+
+inline void print_report(const std::vector<resource_run>& runs, int repeat) {
+  std::cout << "\nsection report: " << DEMO_VECTOR_NAME << ", best of " << repeat << " runs\n";
+  std::cout << std::left << std::setw(22) << "section" << std::setw(12) << "resource" << std::right
+            << std::setw(8) << "allocs" << std::setw(10) << "bytes" << std::setw(10) << "peak B"
+            << std::setw(12) << "time ns" << std::setw(12) << "saved ns" << '\n';
+  const resource_run& baseline = runs.front();
+  for (std::size_t i = 0; i < baseline.best.size(); ++i)
+  {
+    for (const resource_run& run : runs)
+    {
+      if (i >= run.best.size()) continue;
+      const demo_sections::section& s = run.best[i];
+      std::cout << std::left << std::setw(22) << s.name << std::setw(12) << run.resource << std::right;
+#if defined(DEMO_VECTOR_USES_PMR)
+      std::cout << std::setw(8) << s.allocations << std::setw(10) << s.bytes_allocated << std::setw(10) << s.peak_bytes;
+#else
+      std::cout << std::setw(8) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+#endif
+      std::cout << std::setw(12) << std::fixed << std::setprecision(0) << s.ns;
+      if (&run == &baseline) std::cout << std::setw(12) << "-";
+      else std::cout << std::setw(12) << baseline.best[i].ns - s.ns;
+      std::cout << '\n';
+    }
+  }
+}
+
+} // namespace demo_detail
+
+inline int run_demo_tool(int argc, const char * argv[], demo_fn demos) {
+  bool report = false;
+  int repeat = 200;
+  const char* resource = "new_delete";
+  const char* trace_path = nullptr;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--report") == 0) report = true;
+    else if (std::strncmp(argv[i], "--repeat=", 9) == 0) repeat = std::max(1, std::atoi(argv[i] + 9));
+    else if (std::strncmp(argv[i], "--resource=", 11) == 0) resource = argv[i] + 11;
+    else if (std::strncmp(argv[i], "--trace=", 8) == 0) trace_path = argv[i] + 8;
+    else
+    {
+      std::cerr << "unknown option: " << argv[i] << '\n';
+      return 2;
+    }
+  }
+
+#if defined(DEMO_VECTOR_USES_PMR)
+  arena_resource arena;
+  std::pmr::memory_resource* upstream = std::pmr::new_delete_resource();
+  if (std::strcmp(resource, "arena") == 0) upstream = &arena;
+  else if (std::strcmp(resource, "pool") == 0) upstream = thread_local_pool();
+  else if (std::strcmp(resource, "new_delete") != 0)
+  {
+    std::cerr << "unknown resource: " << resource << " (new_delete, arena or pool)\n";
+    return 2;
+  }
+  std::pmr::memory_resource* previous = std::pmr::set_default_resource(upstream);
+  {
+    demo_sections sections;
+    demos(sections);
+  }
+  std::pmr::set_default_resource(previous);
+#else
+  if (std::strcmp(resource, "new_delete") != 0)
+  {
+    std::cerr << "--resource needs a build with -DVECTORS_DEMO_PMR_VECTOR\n";
+    return 2;
+  }
+  {
+    demo_sections sections;
+    demos(sections);
+  }
+#endif
+
+#if defined(DEMO_VECTOR_USES_TRACING)
+  if (trace_path)
+  {
+    std::ofstream trace (trace_path);
+    if (!trace)
+    {
+      std::cerr << "cannot write " << trace_path << '\n';
+      return 1;
+    }
+    trace_log::instance().write_chrome_trace(trace);
+  }
+  if (report)
+  {
+    std::cout << "\nallocations and element copies/moves per section\n";
+    trace_log::instance().write_report(std::cout);
+  }
+#else
+  if (trace_path)
+  {
+    std::cerr << "--trace needs a build with -DVECTORS_DEMO_TRACING_VECTOR\n";
+    return 2;
+  }
+#endif
+
+  if (report)
+  {
+    std::vector<demo_detail::resource_run> runs;
+#if defined(DEMO_VECTOR_USES_PMR)
+    for (const char* r : {"new_delete", "arena", "pool"})
+      runs.push_back(demo_detail::measure(demos, r, repeat));
+#else
+    runs.push_back(demo_detail::measure(demos, "default", repeat));
+#endif
+    demo_detail::print_report(runs, repeat);
+  }
+  return 0;
+}
+
+#endif /* demo_report_hpp */
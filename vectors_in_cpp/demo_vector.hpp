@@ -0,0 +1,66 @@
+//
+//  demo_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// demo_vector<T> is the container every section of main.cpp is written against
+// By default it is plain std::vector<T>; a preprocessor flag swaps in one of the alternatives
+// so the same demo code can be run (and compared) on each of them
+//
+// How?
+// - (no flag)                   std::vector<T>
+// - -DVECTORS_DEMO_SMALL_VECTOR small_vector<T, 16>, see small_vector.hpp
+// - -DVECTORS_DEMO_PMR_VECTOR   std::pmr::vector<T> on the default memory resource, which main.cpp
+//                               selects at runtime (--resource=new_delete|arena|pool), see arena.hpp
+// - -DVECTORS_DEMO_TRACING_VECTOR std::vector<T, tracing_allocator<T>>, counts allocations, copies and
+//                               moves per section (--report) and writes a timeline (--trace=<file>), see tracing.hpp
+// - -DVECTORS_DEMO_STATIC_VECTOR static_vector<T, 128>, no allocation at all, see static_vector.hpp
+// - -DVECTORS_DEMO_CHECKED_VECTOR checked_vector<T>, [], front(), back() and stale iterators are
+//                               diagnosed instead of undefined, see checked_vector.hpp
+
+#ifndef demo_vector_hpp
+#define demo_vector_hpp
+
+#if defined(VECTORS_DEMO_SMALL_VECTOR)
+
+#include "small_vector.hpp"
+template <class T> using demo_vector = small_vector<T, 16>;
+#define DEMO_VECTOR_NAME "small_vector<T, 16>"
+
+#elif defined(VECTORS_DEMO_PMR_VECTOR)
+
+#include <memory_resource>
+#include <vector>
+template <class T> using demo_vector = std::pmr::vector<T>;
+#define DEMO_VECTOR_NAME "std::pmr::vector<T>"
+#define DEMO_VECTOR_USES_PMR 1
+
+#elif defined(VECTORS_DEMO_TRACING_VECTOR)
+
+#include "tracing.hpp"
+#include <vector>
+template <class T> using demo_vector = std::vector<T, tracing_allocator<T>>;
+#define DEMO_VECTOR_NAME "std::vector<T, tracing_allocator<T>>"
+#define DEMO_VECTOR_USES_TRACING 1
+
+#elif defined(VECTORS_DEMO_STATIC_VECTOR)
+
+#include "static_vector.hpp"
+template <class T> using demo_vector = static_vector<T, 128>;
+#define DEMO_VECTOR_NAME "static_vector<T, 128>"
+
+#elif defined(VECTORS_DEMO_CHECKED_VECTOR)
+
+#include "checked_vector.hpp"
+template <class T> using demo_vector = checked_vector<T>;
+#define DEMO_VECTOR_NAME "checked_vector<T>"
+
+#else
+
+#include <vector>
+template <class T> using demo_vector = std::vector<T>;
+#define DEMO_VECTOR_NAME "std::vector<T>"
+
+#endif
+
+#endif /* demo_vector_hpp */
@@ -0,0 +1,365 @@
+//
+//  growth_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// growth_vector<T, Growth> is a vector for large buffers with a pluggable growth policy
+// - geometric_growth<2,1>, geometric_growth<3,2>, chunk_growth<K>, exact_growth
+// - trivially copyable T is grown with realloc() and, past mmap_threshold bytes, with anonymous
+//   mmap()/mremap(): the kernel moves the page table entries instead of copying the elements, so
+//   growing a multi-gigabyte buffer neither copies it nor briefly needs twice the memory
+// - large mappings are advised MADV_HUGEPAGE (transparent huge pages) unless set_huge_pages(false)
+// - any other T falls back to allocate + move + destroy, like std::vector
+//
+// How?
+// - growth_vector<int> v;                              // doubles, like most std::vector implementations
+// - growth_vector<int, geometric_growth<3,2>> w;       // 1.5x
+// - growth_vector<record, chunk_growth<1 << 20>> r;    // one million elements more each time
+// - growth_vector<double, exact_growth> e;             // exactly what is needed, relies on mremap
+//
+// Unlike std::vector, the storage of trivially copyable T may move without any element being moved,
+// so pointers into it are invalidated by growth exactly as with std::vector, but never copied.
+
+#ifndef growth_vector_hpp
+#define growth_vector_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Growth policies
+//  next(capacity, needed) returns the new capacity, never less than needed.
+template <std::size_t Num, std::size_t Den>
+struct geometric_growth {
+  static_assert(Num > Den, "geometric growth needs a factor above 1");
+  static std::size_t next(std::size_t capacity, std::size_t needed) noexcept {
+    return std::max<std::size_t>({needed, capacity / Den * Num + capacity % Den * Num / Den, 4});
+  }
+};
+
+template <std::size_t Chunk>
+struct chunk_growth {
+  static_assert(Chunk > 0, "chunk_growth needs a chunk size");
+  static std::size_t next(std::size_t capacity, std::size_t needed) noexcept {
+    std::size_t n = std::max(needed, capacity + Chunk);
+    return (n + Chunk - 1) / Chunk * Chunk;
+  }
+};
+
+struct exact_growth {
+  static std::size_t next(std::size_t, std::size_t needed) noexcept { return needed; }
+};
+
+namespace growth_detail {
+
+// buffers at least this large are mapped instead of malloc'ed (2 MiB, one x86-64 huge page)
+constexpr std::size_t mmap_threshold = std::size_t(2) << 20;
+constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+inline std::size_t round_up(std::size_t n, std::size_t to) noexcept { return (n + to - 1) / to * to; }
+
+#if defined(__linux__)
+inline std::size_t page_size() noexcept {
+  static const std::size_t size = std::size_t(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+inline void advise(void* p, std::size_t bytes, bool huge_pages) noexcept {
+#if defined(MADV_HUGEPAGE)
+  if (huge_pages) madvise(p, bytes, MADV_HUGEPAGE);
+#else
+  (void)p; (void)bytes; (void)huge_pages;
+#endif
+}
+
+inline void* map(std::size_t bytes, bool huge_pages) {
+  void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) throw std::bad_alloc();
+  advise(p, bytes, huge_pages);
+  return p;
+}
+
+inline void* remap(void* p, std::size_t old_bytes, std::size_t new_bytes, bool huge_pages) {
+  void* q = mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE);
+  if (q == MAP_FAILED) throw std::bad_alloc();
+  if (new_bytes > old_bytes) advise(q, new_bytes, huge_pages);
+  return q;
+}
+
+inline void unmap(void* p, std::size_t bytes) noexcept { munmap(p, bytes); }
+#endif
+
+} // namespace growth_detail
+
+template <class T, class Growth = geometric_growth<2,1>>
+class growth_vector {
+  static_assert(alignof(T) <= alignof(std::max_align_t), "growth_vector does not support over-aligned types");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using growth_policy = Growth;
+
+  // elements are moved by realloc()/mremap() instead of by their constructors
+  static constexpr bool relocates_bitwise = std::is_trivially_copyable<T>::value;
+
+  growth_vector() noexcept = default;
+  explicit growth_vector(size_type n) { resize(n); }
+  growth_vector(size_type n, const T& value) { resize(n, value); }
+  growth_vector(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const T& x : init) push_back(x);
+  }
+  growth_vector(const growth_vector& other) : huge_pages_(other.huge_pages_) {
+    reserve(other.size_);
+    try { std::uninitialized_copy(other.begin(), other.end(), data_); }
+    catch (...) { release(); throw; }
+    size_ = other.size_;
+  }
+  growth_vector(growth_vector&& other) noexcept { swap(other); }
+  ~growth_vector() {
+    clear();
+    release();
+  }
+
+  growth_vector& operator=(const growth_vector& other) {
+    if (this != &other) growth_vector(other).swap(*this);
+    return *this;
+  }
+  growth_vector& operator=(growth_vector&& other) noexcept {
+    growth_vector(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  // huge pages only affect mappings made (or grown) after the call
+  void set_huge_pages(bool on) noexcept { huge_pages_ = on; }
+  bool huge_pages() const noexcept { return huge_pages_; }
+  // true while the buffer is an mmap()ed region
+  bool is_mapped() const noexcept { return mapped_; }
+  // bytes of storage currently held (rounded up to pages when mapped)
+  size_type storage_bytes() const noexcept { return bytes_; }
+
+  // element access
+  reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("growth_vector::at");
+    return data_[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("growth_vector::at");
+    return data_[i];
+  }
+  reference operator[](size_type i) noexcept { return data_[i]; }
+  const_reference operator[](size_type i) const noexcept { return data_[i]; }
+  reference front() noexcept { return data_[0]; }
+  const_reference front() const noexcept { return data_[0]; }
+  reference back() noexcept { return data_[size_ - 1]; }
+  const_reference back() const noexcept { return data_[size_ - 1]; }
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  // iterators
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type capacity() const noexcept { return capacity_; }
+  size_type max_size() const noexcept { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+  void reserve(size_type n) {
+    if (n > capacity_) reallocate(n);
+  }
+  void shrink_to_fit() {
+    if (size_ == 0) release();
+    else if (size_ < capacity_) reallocate(size_);
+  }
+
+  // modifiers
+  void clear() noexcept {
+    std::destroy(data_, data_ + size_);
+    size_ = 0;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    if (size_ == capacity_)
+    {
+      // the arguments may refer to an element, build the value before the storage moves
+      T value(std::forward<Args>(args)...);
+      reallocate(Growth::next(capacity_, size_ + 1));
+      ::new (static_cast<void*>(data_ + size_)) T(std::move(value));
+    }
+    else
+    {
+      ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+    }
+    return data_[size_++];
+  }
+
+  void pop_back() noexcept {
+    --size_;
+    data_[size_].~T();
+  }
+
+  void resize(size_type n) {
+    if (n > capacity_) reallocate(std::max(n, Growth::next(capacity_, n)));
+    if (n > size_) std::uninitialized_value_construct(data_ + size_, data_ + n);
+    else std::destroy(data_ + n, data_ + size_);
+    size_ = n;
+  }
+  void resize(size_type n, const T& value) {
+    if (n > capacity_)
+    {
+      T copy(value);
+      reallocate(std::max(n, Growth::next(capacity_, n)));
+      std::uninitialized_fill(data_ + size_, data_ + n, copy);
+    }
+    else if (n > size_)
+    {
+      std::uninitialized_fill(data_ + size_, data_ + n, value);
+    }
+    else
+    {
+      std::destroy(data_ + n, data_ + size_);
+    }
+    size_ = n;
+  }
+
+  void swap(growth_vector& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(bytes_, other.bytes_);
+    std::swap(mapped_, other.mapped_);
+    std::swap(huge_pages_, other.huge_pages_);
+  }
+  friend void swap(growth_vector& a, growth_vector& b) noexcept { a.swap(b); }
+
+  friend bool operator==(const growth_vector& a, const growth_vector& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+  friend bool operator!=(const growth_vector& a, const growth_vector& b) { return !(a == b); }
+  friend bool operator<(const growth_vector& a, const growth_vector& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+private:
+  void reallocate(size_type new_capacity) {
+    if (new_capacity > max_size()) throw std::length_error("growth_vector");
+    size_type new_bytes = new_capacity * sizeof(T);
+    if constexpr (relocates_bitwise) {
+#if defined(__linux__)
+      if (new_bytes >= growth_detail::mmap_threshold)
+      {
+        size_type mapped_bytes = growth_detail::round_up(new_bytes, huge_pages_ ? growth_detail::huge_page_size
+                                                                                : growth_detail::page_size());
+        void* p;
+        if (mapped_)
+        {
+          p = growth_detail::remap(data_, bytes_, mapped_bytes, huge_pages_);
+        }
+        else
+        {
+          p = growth_detail::map(mapped_bytes, huge_pages_);
+          if (size_) std::memcpy(p, static_cast<const void*>(data_), size_ * sizeof(T));
+          std::free(data_);
+        }
+        set_storage(p, mapped_bytes, true);
+        return;
+      }
+      if (mapped_)
+      {
+        // shrinking below the threshold: back to the malloc heap
+        void* p = std::malloc(new_bytes);
+        if (!p) throw std::bad_alloc();
+        std::memcpy(p, static_cast<const void*>(data_), size_ * sizeof(T));
+        growth_detail::unmap(data_, bytes_);
+        set_storage(p, new_bytes, false);
+        return;
+      }
+#endif
+      void* p = std::realloc(static_cast<void*>(data_), new_bytes);
+      if (!p) throw std::bad_alloc();
+      set_storage(p, new_bytes, false);
+    } else {
+      T* p = static_cast<T*>(::operator new(new_bytes));
+      try {
+        if constexpr (std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value)
+          std::uninitialized_move(data_, data_ + size_, p);
+        else
+          std::uninitialized_copy(data_, data_ + size_, p);
+      } catch (...) {
+        ::operator delete(p);
+        throw;
+      }
+      std::destroy(data_, data_ + size_);
+      ::operator delete(data_);
+      set_storage(p, new_bytes, false);
+    }
+  }
+
+  void set_storage(void* p, size_type bytes, bool mapped) noexcept {
+    data_ = static_cast<T*>(p);
+    bytes_ = bytes;
+    capacity_ = bytes / sizeof(T);
+    mapped_ = mapped;
+  }
+
+  void release() noexcept {
+    if (!data_) return;
+#if defined(__linux__)
+    if (mapped_) growth_detail::unmap(data_, bytes_);
+    else
+#endif
+    if constexpr (relocates_bitwise) std::free(data_);
+    else ::operator delete(data_);
+    data_ = nullptr;
+    bytes_ = 0;
+    capacity_ = 0;
+    mapped_ = false;
+  }
+
+  T* data_ = nullptr;
+  size_type size_ = 0;
+  size_type capacity_ = 0;
+  size_type bytes_ = 0;
+  bool mapped_ = false;
+  bool huge_pages_ = true;
+};
+
+#endif /* growth_vector_hpp */
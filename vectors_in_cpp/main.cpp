@@ -10,26 +10,34 @@
 //
 // How?
 // Declaration :
-// - std::vector<int> vec1 = {1,2,3}; // initialiser list
-// - std::vector<int> vec2 {1,2,3}; // uniform initialisation
+// - demo_vector<int> vec1 = {1,2,3}; // initialiser list
+// - demo_vector<int> vec2 {1,2,3}; // uniform initialisation
 // Access :
 // at(), [], front(), back(), data() ...
 // Modify :
 // insert(), emplace(), push_back(), emplace_back(), pop_back()
 // clear(), erase(), resize(), reserve(), swap() ...
+//
+// Every demo below uses demo_vector<int> (std::vector<int> unless the build selects another container)
+// see demo_vector.hpp, e.g. -DVECTORS_DEMO_SMALL_VECTOR runs them all on small_vector<int, 16>
+// and -DVECTORS_DEMO_PMR_VECTOR on std::pmr::vector<int> with --resource=new_delete|arena|pool
 
 #include <iostream>
-#include <vector>
+#include "demo_report.hpp"
+#include "demo_vector.hpp"
 
 
-int main(int argc, const char * argv[]) {
+// Every section starts with sections.begin(), see demo_report.hpp
+// Run with --report for the time (and, on std::pmr::vector, allocations) of each section
+static void run_demos(demo_sections& sections) {
   
+  sections.begin("assign");
   // assign()
-  std::vector<int> first_assign;
-  std::vector<int> second_assign;
-  std::vector<int> third_assign;
+  demo_vector<int> first_assign;
+  demo_vector<int> second_assign;
+  demo_vector<int> third_assign;
   first_assign.assign (7,100); // 7 ints with a value of 100
-  std::vector<int>::iterator vec_assign_it; // vector iterator pointing to nothing (not yet initialised with a value)
+  demo_vector<int>::iterator vec_assign_it; // vector iterator pointing to nothing (not yet initialised with a value)
   vec_assign_it = first_assign.begin()+1;
   second_assign.assign(vec_assign_it,first_assign.end()-1); // the 5 central values of first
   int int_array[] = {1776,7,4};
@@ -39,8 +47,9 @@ int main(int argc, const char * argv[]) {
   std::cout << "Size of third: " << int (third_assign.size()) << '\n';
   
   
+  sections.begin("at");
   // at() - perform operation at this index
-  std::vector<int> vec_at (10);   // 10 zero-initialized ints
+  demo_vector<int> vec_at (10);   // 10 zero-initialized ints
   // assign some values:
   for (unsigned i=0; i<vec_at.size(); i++)
     vec_at.at(i)=i;
@@ -50,8 +59,9 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
 
     
+  sections.begin("back");
   // back() - returns a direct reference to the last element (value)
-  std::vector<int> vec_back;
+  demo_vector<int> vec_back;
   vec_back.push_back(10);
   while (vec_back.back() != 0)
   {
@@ -62,18 +72,20 @@ int main(int argc, const char * argv[]) {
     std::cout << ' ' << vec_back[i];
   std::cout << '\n';
   
+  sections.begin("begin/end");
   // begin()/end() -  returns pointer to first/last element
-  std::vector<int> vec_begin;
+  demo_vector<int> vec_begin;
   for (int i=1; i<=5; i++) vec_begin.push_back(i);
   std::cout << "vec_begin contains:";
-  for (std::vector<int>::iterator it = vec_begin.begin() ; it != vec_begin.end(); ++it)
+  for (demo_vector<int>::iterator it = vec_begin.begin() ; it != vec_begin.end(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
   
   
+  sections.begin("front");
   // front() - returns a reference to the first element in the vector.
   //  Calling this function on an empty container causes undefined behavior.
-  std::vector<int> vec_front;
+  demo_vector<int> vec_front;
   vec_front.push_back(78);
   vec_front.push_back(16);
   // now front equals 78, and back 16
@@ -81,6 +93,7 @@ int main(int argc, const char * argv[]) {
   std::cout << "vec_front.front() is now " << vec_front.front() << '\n';
 
   
+  sections.begin("capacity");
   // capacity()
   //  Returns the size of the storage space currently allocated for the vector, expressed in terms of elements.
   //
@@ -92,7 +105,7 @@ int main(int argc, const char * argv[]) {
   //  The theoretical limit on the size of a vector is given by the member max_size().
   //
   //  Capacity of a vector can be explicitly altered by calling member vector::reserve.
-  std::vector<int> vec_capacity;
+  demo_vector<int> vec_capacity;
   // set some content in the vector:
   for (int i=0; i<100; i++) vec_capacity.push_back(i);
   std::cout << "size: " << (int) vec_capacity.size() << '\n';
@@ -100,6 +113,7 @@ int main(int argc, const char * argv[]) {
   std::cout << "max_size: " << vec_capacity.max_size() << '\n';
   
   
+  sections.begin("cbegin/cend");
   // cbegin()/cend()
   //  Return const_iterator to beginning/ending
   //  Returns a const_iterator pointing to the first/last element in the container.
@@ -107,12 +121,13 @@ int main(int argc, const char * argv[]) {
   //  A const_iterator is an iterator that points to const content. This iterator can be increased and decreased (unless it is itself also const), just like the iterator returned by vector::begin, but it cannot be used to modify the contents it points to, even if the vector object is not itself const.
   //
   //  If the container is empty, the returned iterator value shall not be dereferenced.
-  std::vector<int> vec_cbegin_cend = {10,20,30,40,50};
+  demo_vector<int> vec_cbegin_cend = {10,20,30,40,50};
   std::cout << "vec_cbegin_cend contains:";
   for (auto it = vec_cbegin_cend.cbegin(); it != vec_cbegin_cend.cend(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
   
+  sections.begin("clear");
   // clear()
   //  Removes all elements from the vector (which are destroyed), leaving the container with a size of 0.
   //
@@ -120,7 +135,7 @@ int main(int argc, const char * argv[]) {
   //
   // A typical alternative that forces a reallocation is to use swap:
   //  vector<T>().swap(x);   // clear x reallocating
-  std::vector<int> vec_clear;
+  demo_vector<int> vec_clear;
   vec_clear.push_back (100);
   vec_clear.push_back (200);
   vec_clear.push_back (300);
@@ -137,21 +152,23 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
   
   
+  sections.begin("crbegin/crend");
   // crbegin()/crend()
   //  const_reverse_iterator crbegin() const noexcept;
   //  Return const_reverse_iterator to reverse beginning
   //  Returns a const_reverse_iterator pointing to the last element in the container (i.e., its reverse beginning).
-  std::vector<int> vec_crbegin_crend = {1,2,3,4,5};
+  demo_vector<int> vec_crbegin_crend = {1,2,3,4,5};
   std::cout << "vec_crbegin_crend backwards:";
   for (auto rit = vec_crbegin_crend.crbegin(); rit != vec_crbegin_crend.crend(); ++rit)
     std::cout << ' ' << *rit;
   std::cout << '\n';
   
+  sections.begin("data");
   // data()
   //  Returns a direct pointer to the memory array used internally by the vector to store its owned elements.
   //
   //  Because elements in the vector are guaranteed to be stored in contiguous storage locations in the same order as represented by the vector, the pointer retrieved can be offset to access any element in the array.
-  std::vector<int> vec_data (5);
+  demo_vector<int> vec_data (5);
   int* p = vec_data.data();
   *p = 10;
   ++p;
@@ -163,6 +180,7 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
   
   
+  sections.begin("emplace");
   // emplace()
   //  Construct and insert element
   //  The container is extended by inserting a new element at position. This new element is constructed in place using args as the arguments for its construction.
@@ -176,7 +194,7 @@ int main(int argc, const char * argv[]) {
   //  The element is constructed in-place by calling allocator_traits::construct with args forwarded.
   //
   //  A similar member function exists, insert, which either copies or moves existing objects into the container.
-  std::vector<int> vec_emplace = {10,20,30};
+  demo_vector<int> vec_emplace = {10,20,30};
 
   auto vec_emplace_it = vec_emplace.emplace ( vec_emplace.begin()+1, 100 );
   vec_emplace.emplace ( vec_emplace_it, 200 );
@@ -188,6 +206,7 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
   // 10 200 100 20 30 300
   
+  sections.begin("emplace_back");
   // emplace_back()
   //  Construct and insert element at the end
   //  Inserts a new element at the end of the vector, right after its current last element. This new element is constructed in place using args as the arguments for its constructor.
@@ -197,7 +216,7 @@ int main(int argc, const char * argv[]) {
   //  The element is constructed in-place by calling allocator_traits::construct with args forwarded.
   //
   //  A similar member function exists, push_back, which either copies or moves an existing object into the container.
-  std::vector<int> vec_emplace_back = {10,20,30};
+  demo_vector<int> vec_emplace_back = {10,20,30};
   vec_emplace_back.emplace_back (100);
   vec_emplace_back.emplace_back (200);
   std::cout << "vec_emplace_back contains:";
@@ -206,11 +225,12 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
   
   
+  sections.begin("empty");
   // empty()
   //  Returns whether the vector is empty (i.e. whether its size is 0).
   //
   //  This function does not modify the container in any way. To clear the content of a vector, see vector::clear.
-  std::vector<int> vec_empty;
+  demo_vector<int> vec_empty;
   int sum (0);
   for (int i=1;i<=10;i++) vec_empty.push_back(i);
   while (!vec_empty.empty())
@@ -221,6 +241,7 @@ int main(int argc, const char * argv[]) {
   std::cout << "total: " << sum << '\n';
 
   
+  sections.begin("erase");
   // erase()
   //  Return iterator to end
   //  Returns an iterator referring to the past-the-end element in the vector container.
@@ -230,7 +251,7 @@ int main(int argc, const char * argv[]) {
   //  Because the ranges used by functions of the standard library do not include the element pointed by their closing iterator, this function is often used in combination with vector::begin to specify a range including all the elements in the container.
   //
   //  If the container is empty, this function returns the same as vector::begin.
-  std::vector<int> vec_erase;
+  demo_vector<int> vec_erase;
   // set some values (from 1 to 10)
   for (int i=1; i<=10; i++) vec_erase.push_back(i);
   // erase the 6th element
@@ -243,6 +264,7 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
 
   
+  sections.begin("insert");
   // insert()
   //  Insert elements
   //  The vector is extended by inserting new elements before the element at the specified position, effectively increasing the container size by the number of elements inserted.
@@ -252,14 +274,14 @@ int main(int argc, const char * argv[]) {
   //  Because vectors use an array as their underlying storage, inserting elements in positions other than the vector end causes the container to relocate all the elements that were after position to their new positions. This is generally an inefficient operation compared to the one performed for the same operation by other kinds of sequence containers (such as list or forward_list).
   //
   //  The parameters determine how many elements are inserted and to which values they are initialized:
-  std::vector<int> vec_insert (3,100);
-  std::vector<int>::iterator vec_insert_it;
+  demo_vector<int> vec_insert (3,100);
+  demo_vector<int>::iterator vec_insert_it;
   vec_insert_it = vec_insert.begin();
   vec_insert_it = vec_insert.insert ( vec_insert_it , 200 );
   vec_insert.insert (vec_insert_it,2,300);
   // "vec_insert_it" no longer valid, get a new one:
   vec_insert_it = vec_insert.begin();
-  std::vector<int> vec_insert_2 (2,400);
+  demo_vector<int> vec_insert_2 (2,400);
   vec_insert.insert (vec_insert_it+2,vec_insert_2.begin(),vec_insert_2.end());
   int data_array [] = { 501,502,503 };
   vec_insert.insert (vec_insert.begin(), data_array, data_array+3);
@@ -268,15 +290,17 @@ int main(int argc, const char * argv[]) {
     std::cout << ' ' << *vec_insert_it;
   std::cout << '\n';
   
+  sections.begin("operator=");
   // operator=
   //  Assigns new contents to the container, replacing its current contents, and modifying its size accordingly.
-  std::vector<int> vec_1_equal_op (3,0);
-  std::vector<int> vec_2_equal_op (5,0);
+  demo_vector<int> vec_1_equal_op (3,0);
+  demo_vector<int> vec_2_equal_op (5,0);
   vec_2_equal_op = vec_1_equal_op;
-  vec_1_equal_op = std::vector<int>();
+  vec_1_equal_op = demo_vector<int>();
   std::cout << "Size of foo: " << int(vec_1_equal_op.size()) << '\n';
   std::cout << "Size of bar: " << int(vec_2_equal_op.size()) << '\n';
 
+  sections.begin("operator[]");
   // operator[]
   //  Access element
   //  Returns a reference to the element at position n in the vector container.
@@ -284,8 +308,8 @@ int main(int argc, const char * argv[]) {
   //  A similar member function, vector::at, has the same behavior as this operator function, except that vector::at is BOUND-CHECKED and signals if the requested position is out of range by throwing an out_of_range exception.
   //
   //  Portable programs should never call this function with an argument n that is out of range, since this causes undefined behavior.
-  std::vector<int> vec_at_op (10);   // 10 zero-initialized elements
-  std::vector<int>::size_type sz = vec_at_op.size();
+  demo_vector<int> vec_at_op (10);   // 10 zero-initialized elements
+  demo_vector<int>::size_type sz = vec_at_op.size();
   // assign some values:
   for (unsigned i=0; i<sz; i++) vec_at_op[i]=i;
   // reverse vector using operator[]:
@@ -303,11 +327,12 @@ int main(int argc, const char * argv[]) {
   std::cout << '\n';
 
   
+  sections.begin("pop_back");
   // pop_back()
   //  Removes the last element in the vector, effectively reducing the container size by one.
   //
   //  This destroys the removed element.
-  std::vector<int> vec_pop_back;
+  demo_vector<int> vec_pop_back;
   int vec_pop_back_sum (0);
   vec_pop_back.push_back (100);
   vec_pop_back.push_back (200);
@@ -319,17 +344,19 @@ int main(int argc, const char * argv[]) {
   }
   std::cout << "The elements of vec_pop_back add up to " << vec_pop_back_sum << '\n';
   
+  sections.begin("push_back");
   //push_back()
   //  Add element at the end
   //  Adds a new element at the end of the vector, after its current last element. The content of val is copied (or moved) to the new element.
   //
   //  This effectively increases the container size by one, which causes an automatic reallocation of the allocated storage space if -and only if- the new vector size surpasses the current vector capacity.
-  std::vector<int> vec_push_back;
+  demo_vector<int> vec_push_back;
   int x = 420;
   vec_push_back.push_back (x);
   std::cout << "vec_push_back stores " << int(vec_push_back.size()) << " numbers.\n";
   
   
+  sections.begin("resize");
   // resize()
   //  Change size
   //  Resizes the container so that it contains n elements.
@@ -341,7 +368,7 @@ int main(int argc, const char * argv[]) {
   //  If n is also greater than the current container capacity, an AUTOMATIC REALLOCATION of the allocated storage space takes place.
   //
   //  Notice that this function changes the actual content of the container by inserting or erasing elements from it.
-  std::vector<int> vec_resize;
+  demo_vector<int> vec_resize;
   // set some initial content:
   for (int i=1;i<10;i++) vec_resize.push_back(i);
   vec_resize.resize(5);
@@ -352,6 +379,7 @@ int main(int argc, const char * argv[]) {
     std::cout << ' ' << vec_resize[i];
   std::cout << '\n';
   
+  sections.begin("shrink_to_fit");
   // shrink_to_fit()
   //  Shrink to fit
   //  Requests the container to reduce its capacity to fit its size.
@@ -359,7 +387,7 @@ int main(int argc, const char * argv[]) {
   //  The request is non-binding, and the container implementation is free to optimize otherwise and leave the vector with a capacity greater than its size.
   //
   //  This may cause a reallocation, but has no effect on the vector size and cannot alter its elements.
-  std::vector<int> vec_shrink_to_fit (100);
+  demo_vector<int> vec_shrink_to_fit (100);
   std::cout << "1. capacity of vec_shrink_to_fit: " << vec_shrink_to_fit.capacity() << '\n';
 
   vec_shrink_to_fit.resize(10);
@@ -369,12 +397,13 @@ int main(int argc, const char * argv[]) {
   std::cout << "3. capacity of vec_shrink_to_fit: " << vec_shrink_to_fit.capacity() << '\n';
 
     
+  sections.begin("size");
   // size()
   //  Return size
   //  Returns the number of elements in the vector.
   //
   //  This is the number of actual objects held in the vector, which is not necessarily equal to its storage capacity.
-  std::vector<int> vec_size;
+  demo_vector<int> vec_size;
   std::cout << "0. size: " << vec_size.size() << '\n';
   for (int i=0; i<10; i++) vec_size.push_back(i);
   std::cout << "1. size: " << vec_size.size() << '\n';
@@ -384,6 +413,7 @@ int main(int argc, const char * argv[]) {
   std::cout << "3. size: " << vec_size.size() << '\n';
   
   
+  sections.begin("relational operators");
   // relational operators
   //  Relational operators for vector
   //  Performs the appropriate comparison operation between the vector containers lhs and rhs.
@@ -400,8 +430,8 @@ int main(int argc, const char * argv[]) {
   //  a>=b  - >   !(a<b)
   //
   //  These operators are overloaded in header <vector>.
-  std::vector<int> vec_1_relational_op (3,100);   // three ints with a value of 100
-  std::vector<int> vec_2_relational_op (2,200);   // two ints with a value of 200
+  demo_vector<int> vec_1_relational_op (3,100);   // three ints with a value of 100
+  demo_vector<int> vec_2_relational_op (2,200);   // two ints with a value of 200
 
   if (vec_1_relational_op==vec_2_relational_op) std::cout << "vecs are equal\n";
   if (vec_1_relational_op!=vec_2_relational_op) std::cout << "vecs are not equal\n";
@@ -411,6 +441,7 @@ int main(int argc, const char * argv[]) {
   if (vec_1_relational_op>=vec_2_relational_op) std::cout << "vec_1 is greater than or equal to vec_2\n";
   
   
+  sections.begin("swap");
   // swap(vector)
   //  Exchange contents of vectors
   //  The contents of container x are exchanged with those of y.
@@ -420,26 +451,30 @@ int main(int argc, const char * argv[]) {
   //  All iterators, references and pointers remain valid for the swapped objects.
   //
   //  The containers exchange references to their data, without actually performing any element copy or movement): It behaves as if x.swap(y) was called.
-  std::vector<int> vec_1_swap_vec (3,100);   // three ints with a value of 100
-  std::vector<int> vec_2_swap_vec (5,200);   // five ints with a value of 200
+  demo_vector<int> vec_1_swap_vec (3,100);   // three ints with a value of 100
+  demo_vector<int> vec_2_swap_vec (5,200);   // five ints with a value of 200
   std::swap(vec_1_swap_vec, vec_2_swap_vec);
   std::cout << "vec_1_swap_vec contains:";
-  for (std::vector<int>::iterator it = vec_1_swap_vec.begin(); it!=vec_1_swap_vec.end(); ++it)
+  for (demo_vector<int>::iterator it = vec_1_swap_vec.begin(); it!=vec_1_swap_vec.end(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
   std::cout << "vec_2_swap_vec contains:";
-  for (std::vector<int>::iterator it = vec_2_swap_vec.begin(); it!=vec_2_swap_vec.end(); ++it)
+  for (demo_vector<int>::iterator it = vec_2_swap_vec.begin(); it!=vec_2_swap_vec.end(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
   vec_1_swap_vec.swap(vec_2_swap_vec);
   std::cout << "vec_1_swap_vec contains:";
-  for (std::vector<int>::iterator it = vec_1_swap_vec.begin(); it!=vec_1_swap_vec.end(); ++it)
+  for (demo_vector<int>::iterator it = vec_1_swap_vec.begin(); it!=vec_1_swap_vec.end(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
   std::cout << "vec_2_swap_vec contains:";
-  for (std::vector<int>::iterator it = vec_2_swap_vec.begin(); it!=vec_2_swap_vec.end(); ++it)
+  for (demo_vector<int>::iterator it = vec_2_swap_vec.begin(); it!=vec_2_swap_vec.end(); ++it)
     std::cout << ' ' << *it;
   std::cout << '\n';
-  
-  return 0;
+  sections.end();
+}
+
+
+int main(int argc, const char * argv[]) {
+  return run_demo_tool(argc, argv, run_demos);
 }
@@ -0,0 +1,405 @@
+//
+//  mmap_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// mmap_vector<T> is a vector of trivially copyable T kept in a file and mapped into memory, so a
+// large array saved by one run is available to the next without being read, parsed or copied:
+// opening it maps the file and the pages are loaded by the kernel when they are first touched.
+// - the file starts with a versioned header (magic, version, element size and alignment, size), the
+//   elements follow as the raw contiguous array that data() returns
+// - push_back/resize grow the file with ftruncate() and the mapping with mremap(), geometrically
+// - mmap_mode::read_only maps the file PROT_READ; anything that would change it throws
+// - sync() is a checkpoint: msync() the elements and the header, once it returns the file holds
+//   everything written so far
+// - advise() passes sequential/random/will_need hints to madvise()
+//
+// How?
+// - mmap_vector<int> v ("data.vec", mmap_mode::create);  v.resize(1 << 30);  ...  v.sync();
+// - mmap_vector<int> r ("data.vec", mmap_mode::read_only);  r.advise(mmap_access::sequential);
+//   std::accumulate(r.begin(), r.end(), 0LL);
+// The file is only readable on a machine with the same element layout and byte order (checked on open).
+// Every mmap_vector opened read-write on a file shares its contents, but not its size: use one writer.
+// POSIX only; growing the mapping in place uses mremap() on Linux and munmap() + mmap() elsewhere.
+
+#ifndef mmap_vector_hpp
+#define mmap_vector_hpp
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class mmap_mode {
+  read_only,        // the file must exist
+  read_write,       // the file must exist
+  open_or_create,   // an empty vector if the file does not exist
+  create            // an empty vector, an existing file is truncated
+};
+
+enum class mmap_access { normal, sequential, random, will_need };
+
+namespace mmap_detail {
+
+// on-disk layout, version 1: this header, then size elements of element_size bytes; the file may be
+// longer than that, the rest is capacity
+struct file_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;      // byte_order_mark as written by the creating machine
+  std::uint64_t header_bytes;    // where the elements start
+  std::uint64_t element_size;
+  std::uint64_t element_align;
+  std::uint64_t size;
+  std::uint64_t reserved[2];
+};
+static_assert(sizeof(file_header) == 64, "the header layout is part of the file format");
+
+constexpr char magic[8] = {'V', 'E', 'C', 'M', 'M', 'A', 'P', '\0'};
+constexpr std::uint32_t version = 1;
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+constexpr std::size_t header_bytes = sizeof(file_header);
+
+inline std::size_t page_size() noexcept {
+  static const std::size_t size = std::size_t(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+inline std::size_t round_up(std::size_t n, std::size_t to) noexcept { return (n + to - 1) / to * to; }
+
+[[noreturn]] inline void throw_errno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), "mmap_vector: " + what);
+}
+
+// the mapping of one open file
+class mapped_file {
+public:
+  mapped_file() noexcept = default;
+  mapped_file(const std::string& path, mmap_mode mode) : read_only_(mode == mmap_mode::read_only) {
+    int flags = read_only_ ? O_RDONLY : O_RDWR;
+    if (mode == mmap_mode::open_or_create) flags |= O_CREAT;
+    if (mode == mmap_mode::create) flags |= O_CREAT | O_TRUNC;
+    fd_ = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw_errno("open " + path);
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) fail("fstat " + path);
+    bytes_ = std::size_t(st.st_size);
+    if (bytes_ > 0) map();
+  }
+  mapped_file(mapped_file&& other) noexcept { swap(other); }
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    mapped_file(std::move(other)).swap(*this);
+    return *this;
+  }
+  ~mapped_file() { close(); }
+
+  void swap(mapped_file& other) noexcept {
+    std::swap(fd_, other.fd_);
+    std::swap(base_, other.base_);
+    std::swap(bytes_, other.bytes_);
+    std::swap(read_only_, other.read_only_);
+  }
+
+  char* base() const noexcept { return base_; }
+  std::size_t bytes() const noexcept { return bytes_; }
+  bool read_only() const noexcept { return read_only_; }
+
+  // set the file length (a whole number of pages) and follow it with the mapping
+  void resize(std::size_t bytes) {
+    if (bytes == bytes_) return;
+    if (::ftruncate(fd_, off_t(bytes)) != 0) throw_errno("ftruncate");
+    if (!base_)
+    {
+      bytes_ = bytes;
+      map();
+      return;
+    }
+#if defined(__linux__)
+    void* p = ::mremap(base_, bytes_, bytes, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) throw_errno("mremap");
+    base_ = static_cast<char*>(p);
+    bytes_ = bytes;
+#else
+    ::munmap(base_, bytes_);
+    base_ = nullptr;
+    bytes_ = bytes;
+    map();
+#endif
+  }
+
+  void sync(bool wait) const {
+    if (base_ && ::msync(base_, bytes_, wait ? MS_SYNC : MS_ASYNC) != 0) throw_errno("msync");
+  }
+
+  void advise(char* p, std::size_t bytes, mmap_access access) const noexcept {
+    if (!base_ || bytes == 0) return;
+    // madvise wants a page aligned start
+    char* start = base_ + (std::size_t(p - base_) / page_size()) * page_size();
+    int advice = access == mmap_access::sequential ? MADV_SEQUENTIAL
+               : access == mmap_access::random ? MADV_RANDOM
+               : access == mmap_access::will_need ? MADV_WILLNEED
+               : MADV_NORMAL;
+    ::madvise(start, std::size_t(p + bytes - start), advice);
+  }
+
+private:
+  void map() {
+    int prot = read_only_ ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* p = ::mmap(nullptr, bytes_, prot, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) fail("mmap");
+    base_ = static_cast<char*>(p);
+  }
+
+  [[noreturn]] void fail(const std::string& what) {
+    int error = errno;
+    close();
+    errno = error;
+    throw_errno(what);
+  }
+
+  void close() noexcept {
+    if (base_) ::munmap(base_, bytes_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+  }
+
+  int fd_ = -1;
+  char* base_ = nullptr;
+  std::size_t bytes_ = 0;
+  bool read_only_ = false;
+};
+
+} // namespace mmap_detail
+
+template <class T>
+class mmap_vector {
+  static_assert(std::is_trivially_copyable<T>::value, "mmap_vector stores its elements as raw bytes");
+  static_assert(alignof(T) <= mmap_detail::header_bytes, "mmap_vector elements start right after the header");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  mmap_vector() noexcept = default;
+  explicit mmap_vector(const std::string& path, mmap_mode mode = mmap_mode::open_or_create)
+    : file_(path, mode) {
+    if (file_.bytes() == 0)
+    {
+      if (file_.read_only()) throw std::runtime_error("mmap_vector: " + path + " is empty");
+      file_.resize(file_bytes_for(0));
+      init_header();
+    }
+    else
+    {
+      check_header(path);
+    }
+    update_capacity();
+  }
+  mmap_vector(const mmap_vector&) = delete;
+  mmap_vector& operator=(const mmap_vector&) = delete;
+  mmap_vector(mmap_vector&& other) noexcept { swap(other); }
+  mmap_vector& operator=(mmap_vector&& other) noexcept {
+    mmap_vector(std::move(other)).swap(*this);
+    return *this;
+  }
+  // unmapping does not wait for the data to reach the disk, call sync() for that
+  ~mmap_vector() = default;
+
+  bool is_open() const noexcept { return file_.base() != nullptr; }
+  bool read_only() const noexcept { return file_.read_only(); }
+  // bytes the file takes, header and capacity included
+  size_type file_bytes() const noexcept { return file_.bytes(); }
+
+  // checkpoint: write the elements and the size back to the file; wait = false only schedules it
+  void sync(bool wait = true) const { file_.sync(wait); }
+  // hint how [first, first + count) (by default everything) is going to be read
+  void advise(mmap_access access) const noexcept { advise(access, 0, size()); }
+  void advise(mmap_access access, size_type first, size_type count) const noexcept {
+    file_.advise(reinterpret_cast<char*>(data_ + first), count * sizeof(T), access);
+  }
+
+  // element access
+  reference at(size_type i) {
+    if (i >= size()) throw std::out_of_range("mmap_vector::at");
+    return data_[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size()) throw std::out_of_range("mmap_vector::at");
+    return data_[i];
+  }
+  reference operator[](size_type i) noexcept { return data_[i]; }
+  const_reference operator[](size_type i) const noexcept { return data_[i]; }
+  reference front() noexcept { return data_[0]; }
+  const_reference front() const noexcept { return data_[0]; }
+  reference back() noexcept { return data_[size() - 1]; }
+  const_reference back() const noexcept { return data_[size() - 1]; }
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  // iterators
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size(); }
+  const_iterator end() const noexcept { return data_ + size(); }
+  const_iterator cend() const noexcept { return data_ + size(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return header_ ? size_type(header_->size) : 0; }
+  size_type capacity() const noexcept { return capacity_; }
+  size_type max_size() const noexcept {
+    return (std::size_t(std::numeric_limits<off_t>::max()) - mmap_detail::header_bytes) / sizeof(T);
+  }
+
+  void reserve(size_type n) {
+    if (n > capacity_) grow_to(n);
+  }
+  // gives the pages past the last element back to the file system
+  void shrink_to_fit() {
+    writable();
+    file_.resize(file_bytes_for(size()));
+    update_capacity();
+  }
+
+  // modifiers
+  void clear() {
+    writable();
+    header_->size = 0;
+  }
+
+  void push_back(const T& value) {
+    if (size() == capacity_)
+    {
+      // value may be an element, copy it before the mapping moves
+      T copy(value);
+      grow_to(next_capacity(size() + 1));
+      data_[header_->size++] = copy;
+    }
+    else
+    {
+      writable();
+      data_[header_->size++] = value;
+    }
+  }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    push_back(T(std::forward<Args>(args)...));
+    return back();
+  }
+
+  void pop_back() {
+    writable();
+    --header_->size;
+  }
+
+  void resize(size_type n) { resize(n, T()); }
+  void resize(size_type n, const T& value) {
+    writable();
+    if (n > capacity_)
+    {
+      T copy(value);
+      grow_to(std::max(n, next_capacity(n)));
+      std::uninitialized_fill(data_ + size(), data_ + n, copy);
+    }
+    else if (n > size())
+    {
+      std::uninitialized_fill(data_ + size(), data_ + n, value);
+    }
+    header_->size = n;
+  }
+
+  void swap(mmap_vector& other) noexcept {
+    file_.swap(other.file_);
+    std::swap(header_, other.header_);
+    std::swap(data_, other.data_);
+    std::swap(capacity_, other.capacity_);
+  }
+  friend void swap(mmap_vector& a, mmap_vector& b) noexcept { a.swap(b); }
+
+private:
+  static size_type file_bytes_for(size_type n) noexcept {
+    return mmap_detail::round_up(mmap_detail::header_bytes + n * sizeof(T), mmap_detail::page_size());
+  }
+
+  static size_type next_capacity(size_type needed) noexcept { return std::max(needed, needed / 2 * 3); }
+
+  void writable() const {
+    if (!is_open()) throw std::logic_error("mmap_vector: no file");
+    if (read_only()) throw std::logic_error("mmap_vector: opened read-only");
+  }
+
+  void grow_to(size_type n) {
+    writable();
+    if (n > max_size()) throw std::length_error("mmap_vector");
+    file_.resize(file_bytes_for(n));
+    update_capacity();
+  }
+
+  void update_capacity() noexcept {
+    header_ = reinterpret_cast<mmap_detail::file_header*>(file_.base());
+    data_ = reinterpret_cast<T*>(file_.base() + mmap_detail::header_bytes);
+    capacity_ = (file_.bytes() - mmap_detail::header_bytes) / sizeof(T);
+  }
+
+  void init_header() noexcept {
+    auto* h = reinterpret_cast<mmap_detail::file_header*>(file_.base());
+    std::memset(static_cast<void*>(h), 0, sizeof(*h));
+    std::memcpy(h->magic, mmap_detail::magic, sizeof(h->magic));
+    h->version = mmap_detail::version;
+    h->byte_order = mmap_detail::byte_order_mark;
+    h->header_bytes = mmap_detail::header_bytes;
+    h->element_size = sizeof(T);
+    h->element_align = alignof(T);
+    h->size = 0;
+  }
+
+  void check_header(const std::string& path) const {
+    auto* h = reinterpret_cast<const mmap_detail::file_header*>(file_.base());
+    auto bad = [&path](const char* why) { return std::runtime_error("mmap_vector: " + path + ": " + why); };
+    if (file_.bytes() < mmap_detail::header_bytes || std::memcmp(h->magic, mmap_detail::magic, sizeof(h->magic)) != 0)
+      throw bad("not an mmap_vector file");
+    if (h->version != mmap_detail::version) throw bad("unsupported version");
+    if (h->byte_order != mmap_detail::byte_order_mark) throw bad("written with another byte order");
+    if (h->header_bytes != mmap_detail::header_bytes) throw bad("unexpected header size");
+    if (h->element_size != sizeof(T) || h->element_align != alignof(T)) throw bad("element type mismatch");
+    if (h->size > (file_.bytes() - mmap_detail::header_bytes) / sizeof(T)) throw bad("truncated");
+  }
+
+  mmap_detail::mapped_file file_;
+  mmap_detail::file_header* header_ = nullptr;
+  T* data_ = nullptr;
+  size_type capacity_ = 0;
+};
+
+#endif /* mmap_vector_hpp */
@@ -0,0 +1,440 @@
+//
+//  parallel.hpp
+//  vectors_in_cpp
+//
+// What?
+// Multi-threaded versions of the bulk operations of main.cpp, run over chunks of a vector
+// - work_stealing_pool: worker threads with one deque each; a range is split in halves down to the
+//                       grain size, a thread works on its own newest half and idle threads steal the
+//                       oldest (largest) halves from the others
+// - fill() / assign()  : assign(n, value)
+// - resize()           : resize(n, value), with the new elements written by the pool; on a
+//                        first_touch_vector the pages are first touched there too (see below)
+// - for_each() / for_each_index(): the element-wise loops, e.g. vec_at.at(i)=i
+// - mismatch() / equal() / less(): operator== and operator< of the relational section
+// - reduce() / sum()   : the accumulate loops, partial results combined in a fixed order
+//
+// How?
+// - parallel::work_stealing_pool pool (8);          // 8-way: 7 workers + the calling thread
+// - parallel::for_each_index(pool, v, [](std::size_t i, int& x) { x = int(i); });
+// - std::int64_t total = parallel::sum(pool, v, 1 << 16);   // the last argument is the grain
+// - parallel::first_touch_vector<double> big;  parallel::resize(pool, big, 1 << 28);
+//
+// Grain is the largest number of elements one task handles. Too small and the task overhead shows,
+// too large and some threads run out of work early; parallel::default_grain is a starting point.
+// On a NUMA machine Linux places a page on the node of the thread that first writes it. std::vector's
+// own resize() writes every new element on the calling thread; first_touch_vector (a std::vector
+// whose allocator default-initializes) leaves that to parallel::resize(), so the pages of a large
+// vector are spread over the nodes of the threads that later work on them. This only pays off with
+// the workers pinned (pin_threads, or numactl/taskset) and for allocations large enough to be fresh
+// pages from mmap.
+// sum() and the relational operations on ints run the kernels of simd_kernels.hpp on every chunk,
+// so simd_kernels.cpp has to be built in.
+
+#ifndef parallel_hpp
+#define parallel_hpp
+
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace parallel {
+
+constexpr std::size_t default_grain = std::size_t(1) << 15;
+
+class work_stealing_pool {
+public:
+  // threads is the total parallelism, the thread calling parallel_for included (0 = all cores);
+  // pin_threads binds worker i to CPU i (Linux), which first-touch placement relies on
+  explicit work_stealing_pool(unsigned threads = 0, bool pin_threads = false)
+    : size_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      queues_(new queue[size_]) {
+    workers_.reserve(size_ - 1);
+    for (unsigned i = 1; i < size_; ++i)
+    {
+      workers_.emplace_back([this, i] { work(i); });
+      if (pin_threads) pin(workers_.back(), i);
+    }
+  }
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  ~work_stealing_pool() {
+    {
+      std::lock_guard<std::mutex> lock (sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) t.join();
+  }
+
+  unsigned size() const noexcept { return size_; }
+
+  // Calls body(lo, hi) on disjoint subranges of [begin, end), none longer than grain, and returns
+  // when all of them are done. The calling thread works too. The first exception thrown by body
+  // is rethrown here (the subranges not started yet are skipped).
+  template <class Body>
+  void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Body&& body) {
+    if (end <= begin) return;
+    grain = std::max<std::size_t>(grain, 1);
+    if (size_ == 1 || end - begin <= grain)
+    {
+      body(begin, end);
+      return;
+    }
+    using body_type = std::remove_reference_t<Body>;
+    job j;
+    j.invoke = [](void* b, std::size_t lo, std::size_t hi) { (*static_cast<body_type*>(b))(lo, hi); };
+    j.body = const_cast<void*>(static_cast<const void*>(std::addressof(body)));
+    j.grain = grain;
+    j.remaining.store(end - begin, std::memory_order_relaxed);
+
+    unsigned self = slot();
+    execute(task{&j, begin, end}, self);
+    while (j.remaining.load(std::memory_order_acquire) != 0)
+    {
+      task t;
+      if (take(self, t)) execute(t, self);
+      else std::this_thread::yield();
+    }
+    if (j.error) std::rethrow_exception(j.error);
+  }
+
+  // a process-wide pool using every core, created on first use
+  static work_stealing_pool& shared() {
+    static work_stealing_pool pool;
+    return pool;
+  }
+
+private:
+  // one parallel_for call; lives on the stack of the thread that made it
+  struct job {
+    void (*invoke)(void* body, std::size_t lo, std::size_t hi) = nullptr;
+    void* body = nullptr;
+    std::size_t grain = 1;
+    std::atomic<std::size_t> remaining {0};   // elements not processed yet
+    std::atomic<bool> failed {false};
+    std::exception_ptr error;
+  };
+
+  struct task {
+    job* owner = nullptr;
+    std::size_t lo = 0;
+    std::size_t hi = 0;
+  };
+
+  // cache line aligned, so neighbouring queues' locks do not share a line
+  struct alignas(64) queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  struct thread_slot {
+    const work_stealing_pool* pool = nullptr;
+    unsigned index = 0;
+  };
+
+  static thread_slot& current() {
+    thread_local thread_slot s;
+    return s;
+  }
+
+  // workers own queues 1..size-1, every other thread shares queue 0
+  unsigned slot() const noexcept { return current().pool == this ? current().index : 0; }
+
+  static void pin(std::thread& t, unsigned index) {
+#if defined(__linux__)
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+    (void)index;
+#endif
+  }
+
+  void push(unsigned self, const task& t) {
+    {
+      std::lock_guard<std::mutex> lock (queues_[self].mutex);
+      queues_[self].tasks.push_back(t);
+    }
+    queued_.fetch_add(1);
+    if (sleepers_.load() > 0)
+    {
+      { std::lock_guard<std::mutex> lock (sleep_mutex_); }
+      wake_.notify_one();
+    }
+  }
+
+  // newest task of our own queue, else the oldest one of another queue
+  bool take(unsigned self, task& out) {
+    {
+      std::lock_guard<std::mutex> lock (queues_[self].mutex);
+      if (!queues_[self].tasks.empty())
+      {
+        out = queues_[self].tasks.back();
+        queues_[self].tasks.pop_back();
+        queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    for (unsigned k = 1; k < size_; ++k)
+    {
+      queue& victim = queues_[(self + k) % size_];
+      std::lock_guard<std::mutex> lock (victim.mutex);
+      if (!victim.tasks.empty())
+      {
+        out = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void execute(task t, unsigned self) {
+    job& j = *t.owner;
+    while (t.hi - t.lo > j.grain)
+    {
+      std::size_t mid = t.lo + (t.hi - t.lo) / 2;
+      push(self, task{t.owner, mid, t.hi});
+      t.hi = mid;
+    }
+    if (!j.failed.load(std::memory_order_relaxed))
+    {
+      try {
+        j.invoke(j.body, t.lo, t.hi);
+      } catch (...) {
+        if (!j.failed.exchange(true)) j.error = std::current_exception();
+      }
+    }
+    // the last access to j: once remaining is 0 the owner may return and destroy it
+    j.remaining.fetch_sub(t.hi - t.lo, std::memory_order_acq_rel);
+  }
+
+  void work(unsigned self) {
+    current() = thread_slot{this, self};
+    for (;;)
+    {
+      task t;
+      if (take(self, t))
+      {
+        execute(t, self);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock (sleep_mutex_);
+      sleepers_.fetch_add(1);
+      wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+      sleepers_.fetch_sub(1);
+      if (stop_ && queued_.load() == 0) return;
+    }
+  }
+
+  unsigned size_;
+  std::unique_ptr<queue[]> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> queued_ {0};
+  std::atomic<unsigned> sleepers_ {0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+
+// std::allocator, except that value-initialization without arguments becomes default-initialization,
+// so resize() of a vector of trivial types leaves the new memory untouched
+template <class T, class Base = std::allocator<T>>
+class default_init_allocator : public Base {
+  using traits = std::allocator_traits<Base>;
+public:
+  template <class U>
+  struct rebind {
+    using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+  };
+
+  using Base::Base;
+  default_init_allocator() = default;
+  template <class U, class B>
+  default_init_allocator(const default_init_allocator<U, B>& other) noexcept : Base(other) {}
+
+  template <class U>
+  void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+    ::new (static_cast<void*>(p)) U;
+  }
+  template <class U, class... Args>
+  void construct(U* p, Args&&... args) {
+    traits::construct(static_cast<Base&>(*this), p, std::forward<Args>(args)...);
+  }
+};
+
+template <class T>
+using first_touch_vector = std::vector<T, default_init_allocator<T>>;
+
+
+template <class Vec>
+using value_of = typename Vec::value_type;
+
+template <class Vec>
+constexpr bool is_int_vector = std::is_same<value_of<Vec>, std::int32_t>::value;
+
+// v[i] = value for every element
+template <class Vec>
+void fill(work_stealing_pool& pool, Vec& v, const value_of<Vec>& value, std::size_t grain = default_grain) {
+  auto* p = v.data();
+  pool.parallel_for(0, v.size(), grain, [p, &value](std::size_t lo, std::size_t hi) {
+    std::fill(p + lo, p + hi, value);
+  });
+}
+
+// resize(n) followed by parallel initialization of the new elements to value. On a first_touch_vector
+// of a trivial type resize() leaves the new memory alone and the workers are the first to touch it;
+// other vectors value-initialize on this thread first.
+template <class Vec>
+void resize(work_stealing_pool& pool, Vec& v, std::size_t n, const value_of<Vec>& value = value_of<Vec>(),
+            std::size_t grain = default_grain) {
+  std::size_t old_size = v.size();
+  v.resize(n);
+  if (n <= old_size) return;
+  auto* p = v.data();
+  pool.parallel_for(old_size, n, grain, [p, &value](std::size_t lo, std::size_t hi) {
+    std::fill(p + lo, p + hi, value);
+  });
+}
+
+// assign(n, value): every element, old or new, is written by the pool
+template <class Vec>
+void assign(work_stealing_pool& pool, Vec& v, std::size_t n, const value_of<Vec>& value,
+            std::size_t grain = default_grain) {
+  if (n > v.capacity())
+  {
+    Vec fresh (v.get_allocator());
+    fresh.reserve(n);
+    v.swap(fresh);
+  }
+  v.resize(n);
+  fill(pool, v, value, grain);
+}
+
+// fn(v[i]) for every element
+template <class Vec, class Fn>
+void for_each(work_stealing_pool& pool, Vec& v, Fn fn, std::size_t grain = default_grain) {
+  auto* p = v.data();
+  pool.parallel_for(0, v.size(), grain, [p, &fn](std::size_t lo, std::size_t hi) {
+    for (std::size_t i = lo; i < hi; ++i) fn(p[i]);
+  });
+}
+
+// fn(i, v[i]) for every element, the vec_at loop
+template <class Vec, class Fn>
+void for_each_index(work_stealing_pool& pool, Vec& v, Fn fn, std::size_t grain = default_grain) {
+  auto* p = v.data();
+  pool.parallel_for(0, v.size(), grain, [p, &fn](std::size_t lo, std::size_t hi) {
+    for (std::size_t i = lo; i < hi; ++i) fn(i, p[i]);
+  });
+}
+
+// Index of the first position where a and b differ, min(a.size(), b.size()) if none.
+// A chunk that starts after a mismatch already found is skipped.
+template <class Vec>
+std::size_t mismatch(work_stealing_pool& pool, const Vec& a, const Vec& b, std::size_t grain = default_grain) {
+  const std::size_t n = std::min(a.size(), b.size());
+  const auto* pa = a.data();
+  const auto* pb = b.data();
+  std::atomic<std::size_t> first {n};
+  pool.parallel_for(0, n, grain, [&](std::size_t lo, std::size_t hi) {
+    if (lo >= first.load(std::memory_order_relaxed)) return;
+    std::size_t i;
+    if constexpr (is_int_vector<Vec>) i = lo + simd::mismatch(pa + lo, pb + lo, hi - lo);
+    else i = std::size_t(std::mismatch(pa + lo, pa + hi, pb + lo).first - pa);
+    if (i == hi) return;
+    std::size_t seen = first.load(std::memory_order_relaxed);
+    while (i < seen && !first.compare_exchange_weak(seen, i, std::memory_order_relaxed)) {}
+  });
+  return first.load();
+}
+
+// a == b
+template <class Vec>
+bool equal(work_stealing_pool& pool, const Vec& a, const Vec& b, std::size_t grain = default_grain) {
+  return a.size() == b.size() && mismatch(pool, a, b, grain) == a.size();
+}
+
+// a < b (lexicographical compare)
+template <class Vec>
+bool less(work_stealing_pool& pool, const Vec& a, const Vec& b, std::size_t grain = default_grain) {
+  std::size_t i = mismatch(pool, a, b, grain);
+  if (i < a.size() && i < b.size()) return a.data()[i] < b.data()[i];
+  return a.size() < b.size();
+}
+
+namespace parallel_detail {
+
+// chunk(lo, hi) on every grain-sized chunk of [0, n), the results folded into init left to right
+template <class R, class Chunk, class Combine>
+R reduce_chunks(work_stealing_pool& pool, std::size_t n, std::size_t grain, R init, Chunk chunk, Combine combine) {
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t chunks = (n + grain - 1) / grain;
+  std::vector<R> partial (chunks, init);
+  pool.parallel_for(0, chunks, 1, [&](std::size_t first, std::size_t last) {
+    for (std::size_t c = first; c < last; ++c) partial[c] = chunk(c * grain, std::min(n, (c + 1) * grain));
+  });
+  for (R& r : partial) init = combine(std::move(init), r);
+  return init;
+}
+
+} // namespace parallel_detail
+
+// init op v[0] op v[1] ... with op applied within chunks of grain elements and the chunk results
+// combined left to right, so the result does not depend on scheduling (op must be associative)
+template <class Vec, class R, class Op>
+R reduce(work_stealing_pool& pool, const Vec& v, R init, Op op, std::size_t grain = default_grain) {
+  const auto* p = v.data();
+  auto chunk = [p, &op](std::size_t lo, std::size_t hi) {
+    R acc = R(p[lo]);
+    for (std::size_t i = lo + 1; i < hi; ++i) acc = op(std::move(acc), p[i]);
+    return acc;
+  };
+  return parallel_detail::reduce_chunks(pool, v.size(), grain, std::move(init), chunk, op);
+}
+
+// sum of the elements; ints are summed in 64 bits with simd::sum on every chunk
+template <class Vec>
+auto sum(work_stealing_pool& pool, const Vec& v, std::size_t grain = default_grain) {
+  if constexpr (is_int_vector<Vec>)
+  {
+    const std::int32_t* p = v.data();
+    return parallel_detail::reduce_chunks(pool, v.size(), grain, std::int64_t(0),
+                                          [p](std::size_t lo, std::size_t hi) { return simd::sum(p + lo, hi - lo); },
+                                          std::plus<std::int64_t>());
+  }
+  else
+  {
+    return reduce(pool, v, value_of<Vec>(), std::plus<value_of<Vec>>(), grain);
+  }
+}
+
+} // namespace parallel
+
+#endif /* parallel_hpp */
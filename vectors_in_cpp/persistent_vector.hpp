@@ -0,0 +1,507 @@
+//
+//  persistent_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// persistent_vector<T> is a vector whose copies are O(1) snapshots: the elements live in a 32-way
+// trie plus a tail of up to 32 elements, the nodes are reference counted and shared between copies,
+// and a change copies only the nodes on the path to the element it touches (path copying), never
+// the elements of other nodes. Where operator= of std::vector copies every element, here it copies a
+// pointer, and the first push_back()/set() afterwards copies at most one node per trie level.
+// - push_back / pop_back : amortized O(1), the tail fills up and is then added to the trie whole
+// - set(i, x) / update(i, f) / [] / at : O(log32 n), at most 7 levels for 2^32 elements
+// - transient()          : a transient_vector<T> for batch edits, with a mutable operator[];
+//                          persistent() turns it back into a persistent_vector
+//
+// How?
+// - persistent_vector<int> state;   ...   persistent_vector<int> snapshot = state;   // O(1)
+// - state.set(42, 7);                // copies the path to element 42, snapshot still sees the old value
+// - auto t = state.transient();  for (...) t[i] += 1;  state = t.persistent();
+//
+// A node owned by a single vector (reference count 1) is changed in place, so the second and later
+// changes after a snapshot, and everything a transient does, cost no copies at all. The reference
+// counts are atomic: snapshots may be read, copied and destroyed on other threads while the original
+// keeps changing. Like std::vector, one object must not be changed and used concurrently.
+// Iterators are const: change elements with set()/update(), or through a transient.
+
+#ifndef persistent_vector_hpp
+#define persistent_vector_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <class T> class transient_vector;
+
+namespace persistent_detail {
+
+constexpr unsigned bits = 5;
+constexpr std::size_t width = std::size_t(1) << bits;   // children per node, elements per leaf
+constexpr std::size_t mask = width - 1;
+
+struct node {
+  std::atomic<std::uint32_t> refs {1};
+  std::uint32_t count = 0;   // elements in a leaf; unused in inner nodes
+  bool leaf;
+  explicit node(bool is_leaf) noexcept : leaf(is_leaf) {}
+};
+
+struct inner : node {
+  node* child[width] = {};
+  inner() noexcept : node(false) {}
+};
+
+template <class T>
+struct leaf : node {
+  alignas(T) unsigned char storage[width * sizeof(T)];
+  leaf() noexcept : node(true) {}
+  T* items() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+  const T* items() const noexcept { return std::launder(reinterpret_cast<const T*>(storage)); }
+};
+
+inline void acquire(node* n) noexcept {
+  if (n) n->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <class T>
+void release(node* n) noexcept {
+  if (!n || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  if (n->leaf)
+  {
+    auto* l = static_cast<leaf<T>*>(n);
+    for (std::uint32_t i = 0; i < l->count; ++i) l->items()[i].~T();
+    delete l;
+  }
+  else
+  {
+    auto* in = static_cast<inner*>(n);
+    for (node* c : in->child) release<T>(c);
+    delete in;
+  }
+}
+
+// the trie and the tail; copies share every node
+template <class T>
+struct trie {
+  std::size_t size = 0;
+  unsigned shift = bits;          // bits of the index consumed above the leaves
+  node* root = nullptr;           // an inner node, null until the first tail moves in
+  node* tail = nullptr;           // a leaf
+
+  trie() noexcept = default;
+  trie(const trie& other) noexcept : size(other.size), shift(other.shift), root(other.root), tail(other.tail) {
+    acquire(root);
+    acquire(tail);
+  }
+  trie(trie&& other) noexcept { swap(other); }
+  trie& operator=(trie other) noexcept {
+    swap(other);
+    return *this;
+  }
+  ~trie() { reset(); }
+
+  void swap(trie& other) noexcept {
+    std::swap(size, other.size);
+    std::swap(shift, other.shift);
+    std::swap(root, other.root);
+    std::swap(tail, other.tail);
+  }
+
+  void reset() noexcept {
+    release<T>(root);
+    release<T>(tail);
+    root = nullptr;
+    tail = nullptr;
+    size = 0;
+    shift = bits;
+  }
+
+  // index of the first element in the tail
+  std::size_t tail_offset() const noexcept { return size < width ? 0 : ((size - 1) >> bits) << bits; }
+
+  const leaf<T>* leaf_for(std::size_t i) const noexcept {
+    const node* n = tail;
+    if (i < tail_offset())
+    {
+      n = root;
+      for (unsigned level = shift; level > 0; level -= bits) n = static_cast<const inner*>(n)->child[(i >> level) & mask];
+    }
+    return static_cast<const leaf<T>*>(n);
+  }
+
+  const T& get(std::size_t i) const noexcept { return leaf_for(i)->items()[i & mask]; }
+
+  static leaf<T>* clone(const node* from) {
+    auto* l = static_cast<const leaf<T>*>(from);
+    auto* copy = new leaf<T>();
+    try
+    {
+      for (; copy->count < l->count; ++copy->count)
+        ::new (static_cast<void*>(copy->items() + copy->count)) T(l->items()[copy->count]);
+    }
+    catch (...)
+    {
+      release<T>(copy);
+      throw;
+    }
+    return copy;
+  }
+
+  static bool shared(const node* n) noexcept { return n->refs.load(std::memory_order_acquire) != 1; }
+
+  // make the node in slot this trie's own: a missing one is created, a shared one replaced by a copy
+  static inner* own_inner(node*& slot) {
+    if (!slot) return static_cast<inner*>(slot = new inner());
+    if (!shared(slot)) return static_cast<inner*>(slot);
+    inner* copy = new inner();
+    for (std::size_t k = 0; k < width; ++k)
+    {
+      copy->child[k] = static_cast<inner*>(slot)->child[k];
+      acquire(copy->child[k]);
+    }
+    release<T>(slot);
+    return static_cast<inner*>(slot = copy);
+  }
+
+  static leaf<T>* own_leaf(node*& slot) {
+    if (!slot) return static_cast<leaf<T>*>(slot = new leaf<T>());
+    if (!shared(slot)) return static_cast<leaf<T>*>(slot);
+    leaf<T>* copy = clone(slot);
+    release<T>(slot);
+    return static_cast<leaf<T>*>(slot = copy);
+  }
+
+  // element i, with every node on its path owned
+  T& own(std::size_t i) {
+    if (i >= tail_offset()) return own_leaf(tail)->items()[i & mask];
+    node** slot = &root;
+    for (unsigned level = shift; level > 0; level -= bits) slot = &own_inner(*slot)->child[(i >> level) & mask];
+    return own_leaf(*slot)->items()[i & mask];
+  }
+
+  // args may name an element of this trie: nothing is released before the new element is built
+  template <class... Args>
+  void emplace_back(Args&&... args) {
+    if (size - tail_offset() < width)
+    {
+      leaf<T>* t = !tail ? new leaf<T>() : shared(tail) ? clone(tail) : static_cast<leaf<T>*>(tail);
+      try
+      {
+        ::new (static_cast<void*>(t->items() + t->count)) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        if (t != tail) release<T>(t);
+        throw;
+      }
+      ++t->count;
+      if (t != tail)
+      {
+        release<T>(tail);
+        tail = t;
+      }
+      ++size;
+      return;
+    }
+    // the tail is full: it moves into the trie and a new tail starts
+    leaf<T>* fresh = new leaf<T>();
+    try
+    {
+      ::new (static_cast<void*>(fresh->items())) T(std::forward<Args>(args)...);
+      fresh->count = 1;
+      if ((size >> bits) > (std::size_t(1) << shift))
+      {
+        // the trie is full at this height: grow a level
+        inner* top = new inner();
+        top->child[0] = root;
+        root = top;
+        shift += bits;
+      }
+      push_tail(shift, root);
+    }
+    catch (...)
+    {
+      release<T>(fresh);
+      throw;
+    }
+    tail = fresh;
+    ++size;
+  }
+
+  // hands the full tail to the trie, at index size - 1
+  void push_tail(unsigned level, node*& slot) {
+    inner* n = own_inner(slot);
+    node*& child = n->child[((size - 1) >> level) & mask];
+    if (level == bits) child = tail;
+    else push_tail(level - bits, child);
+  }
+
+  void pop_back() {
+    if (size == 1)
+    {
+      reset();
+      return;
+    }
+    if (size - tail_offset() > 1)
+    {
+      leaf<T>* t = own_leaf(tail);
+      --t->count;
+      t->items()[t->count].~T();
+      --size;
+      return;
+    }
+    // the tail empties: the last leaf of the trie becomes the tail
+    node* last = const_cast<leaf<T>*>(leaf_for(size - 2));
+    acquire(last);
+    try
+    {
+      pop_tail(shift, root);
+    }
+    catch (...)
+    {
+      release<T>(last);
+      throw;
+    }
+    release<T>(tail);
+    tail = last;
+    if (shift > bits && !static_cast<inner*>(root)->child[1])
+    {
+      node* top = root;
+      root = static_cast<inner*>(top)->child[0];
+      acquire(root);
+      release<T>(top);
+      shift -= bits;
+    }
+    --size;
+  }
+
+  // removes the leaf holding index size - 2 from the trie; true when slot became empty
+  bool pop_tail(unsigned level, node*& slot) {
+    std::size_t k = ((size - 2) >> level) & mask;
+    if (k == 0 && level == bits)
+    {
+      release<T>(slot);
+      slot = nullptr;
+      return true;
+    }
+    inner* n = own_inner(slot);
+    if (level == bits)
+    {
+      release<T>(n->child[k]);
+      n->child[k] = nullptr;
+      return false;
+    }
+    if (pop_tail(level - bits, n->child[k]) && k == 0)
+    {
+      release<T>(slot);
+      slot = nullptr;
+      return true;
+    }
+    return false;
+  }
+};
+
+template <class T>
+class const_iterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const T*;
+  using reference = const T&;
+
+  const_iterator() noexcept = default;
+  const_iterator(const trie<T>* owner, std::size_t i) noexcept : owner_(owner), i_(i) {}
+
+  // the leaf of the last element read is kept, so a scan walks the trie once per 32 elements
+  reference operator*() const noexcept {
+    if ((i_ & ~mask) != base_ || !items_)
+    {
+      base_ = i_ & ~mask;
+      items_ = owner_->leaf_for(i_)->items();
+    }
+    return items_[i_ & mask];
+  }
+  pointer operator->() const noexcept { return &**this; }
+  reference operator[](difference_type d) const noexcept { return owner_->get(i_ + std::size_t(d)); }
+
+  const_iterator& operator++() noexcept { ++i_; return *this; }
+  const_iterator operator++(int) noexcept { const_iterator t = *this; ++i_; return t; }
+  const_iterator& operator--() noexcept { --i_; return *this; }
+  const_iterator operator--(int) noexcept { const_iterator t = *this; --i_; return t; }
+  const_iterator& operator+=(difference_type d) noexcept { i_ += std::size_t(d); return *this; }
+  const_iterator& operator-=(difference_type d) noexcept { i_ -= std::size_t(d); return *this; }
+  friend const_iterator operator+(const_iterator it, difference_type d) noexcept { return it += d; }
+  friend const_iterator operator+(difference_type d, const_iterator it) noexcept { return it += d; }
+  friend const_iterator operator-(const_iterator it, difference_type d) noexcept { return it -= d; }
+  friend difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept {
+    return difference_type(a.i_) - difference_type(b.i_);
+  }
+
+  friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ == b.i_; }
+  friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ != b.i_; }
+  friend bool operator<(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ < b.i_; }
+  friend bool operator>(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ > b.i_; }
+  friend bool operator<=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ <= b.i_; }
+  friend bool operator>=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ >= b.i_; }
+
+private:
+  const trie<T>* owner_ = nullptr;
+  std::size_t i_ = 0;
+  mutable std::size_t base_ = 0;
+  mutable const T* items_ = nullptr;
+};
+
+} // namespace persistent_detail
+
+template <class T>
+class persistent_vector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = const T&;
+  using const_reference = const T&;
+  using iterator = persistent_detail::const_iterator<T>;
+  using const_iterator = persistent_detail::const_iterator<T>;
+  using reverse_iterator = std::reverse_iterator<const_iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  persistent_vector() noexcept = default;
+  persistent_vector(size_type n, const T& value) {
+    for (size_type i = 0; i < n; ++i) push_back(value);
+  }
+  persistent_vector(std::initializer_list<T> init) {
+    for (const T& x : init) push_back(x);
+  }
+  template <class It, class = typename std::iterator_traits<It>::iterator_category>
+  persistent_vector(It first, It last) {
+    for (; first != last; ++first) push_back(*first);
+  }
+  // copies and assignments are O(1) and share every node (defaulted: trie counts the references)
+
+  // element access
+  const_reference operator[](size_type i) const noexcept { return trie_.get(i); }
+  const_reference at(size_type i) const {
+    if (i >= size()) throw std::out_of_range("persistent_vector::at");
+    return trie_.get(i);
+  }
+  const_reference front() const noexcept { return trie_.get(0); }
+  const_reference back() const noexcept { return trie_.get(size() - 1); }
+
+  // iterators
+  const_iterator begin() const noexcept { return {&trie_, 0}; }
+  const_iterator cbegin() const noexcept { return {&trie_, 0}; }
+  const_iterator end() const noexcept { return {&trie_, size()}; }
+  const_iterator cend() const noexcept { return {&trie_, size()}; }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  bool empty() const noexcept { return trie_.size == 0; }
+  size_type size() const noexcept { return trie_.size; }
+
+  // modifiers: each copies the nodes it touches that are shared with another vector
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  template <class... Args>
+  void emplace_back(Args&&... args) { trie_.emplace_back(std::forward<Args>(args)...); }
+  // copies the tail first when it is shared
+  void pop_back() { trie_.pop_back(); }
+
+  void set(size_type i, const T& value) {
+    T copy(value);   // value may live in a node that is about to be replaced
+    trie_.own(i) = std::move(copy);
+  }
+  void set(size_type i, T&& value) { trie_.own(i) = std::move(value); }
+  // f(T&) changes element i in place
+  template <class F>
+  void update(size_type i, F&& f) { std::forward<F>(f)(trie_.own(i)); }
+
+  void clear() noexcept { trie_.reset(); }
+  void swap(persistent_vector& other) noexcept { trie_.swap(other.trie_); }
+  friend void swap(persistent_vector& a, persistent_vector& b) noexcept { a.swap(b); }
+
+  // batch edits; the transient starts out sharing every node with this vector
+  transient_vector<T> transient() const& { return transient_vector<T>(trie_); }
+  transient_vector<T> transient() && { return transient_vector<T>(std::move(trie_)); }
+
+  // vectors sharing a node compare it once
+  friend bool operator==(const persistent_vector& a, const persistent_vector& b) {
+    if (a.size() != b.size()) return false;
+    for (size_type i = 0; i < a.size(); i += persistent_detail::width)
+    {
+      const auto* la = a.trie_.leaf_for(i);
+      const auto* lb = b.trie_.leaf_for(i);
+      if (la == lb) continue;
+      for (std::uint32_t k = 0; k < la->count; ++k)
+        if (!(la->items()[k] == lb->items()[k])) return false;
+    }
+    return true;
+  }
+  friend bool operator!=(const persistent_vector& a, const persistent_vector& b) { return !(a == b); }
+
+private:
+  friend class transient_vector<T>;
+  explicit persistent_vector(persistent_detail::trie<T>&& t) noexcept : trie_(std::move(t)) {}
+
+  persistent_detail::trie<T> trie_;
+};
+
+// transient_vector<T>
+//  The batch-editing side of persistent_vector: the same trie, but move-only and with mutable element
+//  access, so a loop of edits reads like one on std::vector. Nodes it shares with the vector it came
+//  from are copied on first write, after that every edit is in place.
+template <class T>
+class transient_vector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+  transient_vector() noexcept = default;
+  transient_vector(const transient_vector&) = delete;
+  transient_vector& operator=(const transient_vector&) = delete;
+  transient_vector(transient_vector&&) noexcept = default;
+  transient_vector& operator=(transient_vector&&) noexcept = default;
+
+  // writes go through the path to i, copying what is still shared
+  reference operator[](size_type i) { return trie_.own(i); }
+  const_reference get(size_type i) const noexcept { return trie_.get(i); }
+  reference at(size_type i) {
+    if (i >= size()) throw std::out_of_range("transient_vector::at");
+    return trie_.own(i);
+  }
+  reference back() { return trie_.own(size() - 1); }
+
+  bool empty() const noexcept { return trie_.size == 0; }
+  size_type size() const noexcept { return trie_.size; }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  template <class... Args>
+  void emplace_back(Args&&... args) { trie_.emplace_back(std::forward<Args>(args)...); }
+  void pop_back() { trie_.pop_back(); }
+  void clear() noexcept { trie_.reset(); }
+
+  // ends the batch: the edits become a persistent_vector, the transient is left empty
+  persistent_vector<T> persistent() noexcept { return persistent_vector<T>(std::move(trie_)); }
+
+private:
+  friend class persistent_vector<T>;
+  explicit transient_vector(const persistent_detail::trie<T>& t) noexcept : trie_(t) {}
+  explicit transient_vector(persistent_detail::trie<T>&& t) noexcept : trie_(std::move(t)) {}
+
+  persistent_detail::trie<T> trie_;
+};
+
+#endif /* persistent_vector_hpp */
@@ -0,0 +1,561 @@
+//
+//  simd_kernels.cpp
+//  vectors_in_cpp
+//
+// The SSE2/AVX2/AVX-512 versions are compiled with per-function target attributes, so this file
+// needs no special compiler flags and the binary still runs on CPUs without AVX.
+
+#include "simd_kernels.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+namespace {
+
+// The scalar versions stay scalar (no auto-vectorization), they are what the others are verified
+// and measured against.
+#if defined(__GNUC__) && !defined(__clang__)
+#define SIMD_SCALAR_ATTR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define SIMD_SCALAR_ATTR
+#endif
+
+// scalar
+SIMD_SCALAR_ATTR
+std::int64_t sum_scalar(const std::int32_t* p, std::size_t n) {
+  std::int64_t total = 0;
+  for (std::size_t i = 0; i < n; ++i) total += p[i];
+  return total;
+}
+
+SIMD_SCALAR_ATTR
+void reverse_scalar(std::int32_t* p, std::size_t n) {
+  for (std::size_t i = 0; i < n / 2; ++i)
+  {
+    std::int32_t temp = p[n-1-i];
+    p[n-1-i] = p[i];
+    p[i] = temp;
+  }
+}
+
+SIMD_SCALAR_ATTR
+std::size_t mismatch_scalar(const std::int32_t* a, const std::int32_t* b, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i)
+    if (a[i] != b[i]) return i;
+  return n;
+}
+
+SIMD_SCALAR_ATTR
+void fill_scalar(std::int32_t* p, std::size_t n, std::int32_t value) {
+  for (std::size_t i = 0; i < n; ++i) p[i] = value;
+}
+
+SIMD_SCALAR_ATTR
+std::size_t find_scalar(const std::int32_t* p, std::size_t n, std::int32_t value) {
+  for (std::size_t i = 0; i < n; ++i)
+    if (p[i] == value) return i;
+  return n;
+}
+
+// branchless: every element is written, the write position only advances for the kept ones
+SIMD_SCALAR_ATTR
+std::size_t compress_scalar(const std::int32_t* src, std::size_t n, const std::uint64_t* remove, std::int32_t* dst) {
+  std::size_t w = 0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    dst[w] = src[i];
+    w += ((remove[i / 64] >> (i % 64)) & 1) ^ 1;
+  }
+  return w;
+}
+
+// value j of a packed block (see kernels::unpack_for)
+inline std::uint32_t unpacked(const std::uint32_t* in, unsigned bits, std::size_t j) {
+  std::size_t bit = (j / 4) * bits;
+  const std::uint32_t* word = in + (bit / 32) * 4 + j % 4;
+  std::uint64_t pair = word[0];
+  if (bit % 32 + bits > 32) pair |= std::uint64_t(word[4]) << 32;
+  return std::uint32_t(pair >> (bit % 32)) & (bits == 32 ? ~0u : (1u << bits) - 1);
+}
+
+SIMD_SCALAR_ATTR
+void unpack_for_scalar(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t* out) {
+  for (std::size_t j = 0; j < 128; ++j) out[j] = base + (bits ? unpacked(in, bits, j) : 0);
+}
+
+SIMD_SCALAR_ATTR
+void unpack_delta_scalar(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t step, std::uint32_t* out) {
+  for (std::size_t j = 0; j < 128; ++j) out[j] = base += (bits ? unpacked(in, bits, j) : 0) + step;
+}
+
+// reflected polynomial 0x82F63B78, one table lookup per byte
+struct crc32c_lut {
+  std::uint32_t entry[256];
+};
+
+constexpr crc32c_lut make_crc32c_lut() {
+  crc32c_lut t {};
+  for (std::uint32_t i = 0; i < 256; ++i)
+  {
+    std::uint32_t c = i;
+    for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+    t.entry[i] = c;
+  }
+  return t;
+}
+
+constexpr crc32c_lut crc32c_table = make_crc32c_lut();
+
+std::uint32_t crc32c_scalar(std::uint32_t crc, const void* p, std::size_t n) {
+  const unsigned char* b = static_cast<const unsigned char*>(p);
+  crc = ~crc;
+  for (std::size_t i = 0; i < n; ++i) crc = (crc >> 8) ^ crc32c_table.entry[(crc ^ b[i]) & 0xFF];
+  return ~crc;
+}
+
+const kernels scalar_kernels = {isa::scalar, &sum_scalar, &reverse_scalar, &mismatch_scalar, &fill_scalar, &find_scalar,
+                                &compress_scalar, &unpack_for_scalar, &unpack_delta_scalar, &crc32c_scalar};
+
+
+#if defined(SIMD_KERNELS_X86)
+
+// SSE2 (4 lanes)
+__attribute__((target("sse2")))
+std::int64_t sum_sse2(const std::int32_t* p, std::size_t n) {
+  __m128i acc = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    __m128i sign = _mm_srai_epi32(x, 31);
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sign));
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sign));
+  }
+  alignas(16) std::int64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+  return lanes[0] + lanes[1] + sum_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void reverse_sse2(std::int32_t* p, std::size_t n) {
+  std::size_t lo = 0, hi = n;
+  while (hi - lo >= 8)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + lo));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + hi - 4));
+    a = _mm_shuffle_epi32(a, _MM_SHUFFLE(0,1,2,3));
+    b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0,1,2,3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + lo), b);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + hi - 4), a);
+    lo += 4;
+    hi -= 4;
+  }
+  reverse_scalar(p + lo, hi - lo);
+}
+
+__attribute__((target("sse2")))
+std::size_t mismatch_sse2(const std::int32_t* a, const std::int32_t* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned mask = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y))));
+    if (mask != 0xF) return i + unsigned(__builtin_ctz(~mask));
+  }
+  return i + mismatch_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void fill_sse2(std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m128i v = _mm_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), v);
+  fill_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("sse2")))
+std::size_t find_sse2(const std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m128i v = _mm_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    unsigned mask = unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, v))));
+    if (mask) return i + unsigned(__builtin_ctz(mask));
+  }
+  return i + find_scalar(p + i, n - i, value);
+}
+
+// One instantiation per bit width, so every shift is a constant of the unrolled loop. Each step
+// decodes the next position of all four lanes, which is four consecutive values.
+template <unsigned Bits, bool Delta>
+__attribute__((target("sse2")))
+void unpack_sse2_bits(const std::uint32_t* in, std::uint32_t base, std::uint32_t step, std::uint32_t* out) {
+  const __m128i* src = reinterpret_cast<const __m128i*>(in);
+  const __m128i mask = _mm_set1_epi32(int(Bits == 32 ? ~0u : (1u << (Bits % 32)) - 1));
+  const __m128i steps = _mm_set1_epi32(int(step));
+  __m128i carry = _mm_set1_epi32(int(base));
+  __m128i w = Bits ? _mm_loadu_si128(src) : _mm_setzero_si128();
+  unsigned shift = 0;
+#pragma GCC unroll 32
+  for (unsigned k = 0; k < 32; ++k)
+  {
+    __m128i v = _mm_srli_epi32(w, int(shift));
+    if (shift + Bits > 32)
+    {
+      w = _mm_loadu_si128(++src);
+      v = _mm_or_si128(v, _mm_slli_epi32(w, int(32 - shift)));
+      shift = shift + Bits - 32;
+    }
+    else if (shift + Bits == 32)
+    {
+      shift = 0;
+      if (k != 31) w = _mm_loadu_si128(++src);
+    }
+    else shift += Bits;
+    v = _mm_and_si128(v, mask);
+    if (Delta)
+    {
+      // prefix sum of the four lanes, on top of the last value of the previous step
+      v = _mm_add_epi32(v, steps);
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+      v = _mm_add_epi32(v, carry);
+      carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,3));
+    }
+    else v = _mm_add_epi32(v, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + k, v);
+  }
+}
+
+using unpack_bits_fn = void (*)(const std::uint32_t*, std::uint32_t, std::uint32_t, std::uint32_t*);
+
+template <bool Delta, std::size_t... Bits>
+constexpr std::array<unpack_bits_fn, 33> unpack_sse2_table(std::index_sequence<Bits...>) {
+  return {{&unpack_sse2_bits<unsigned(Bits), Delta>...}};
+}
+
+constexpr std::array<unpack_bits_fn, 33> unpack_for_sse2_by_bits = unpack_sse2_table<false>(std::make_index_sequence<33>());
+constexpr std::array<unpack_bits_fn, 33> unpack_delta_sse2_by_bits = unpack_sse2_table<true>(std::make_index_sequence<33>());
+
+void unpack_for_sse2(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t* out) {
+  unpack_for_sse2_by_bits[bits](in, base, 0, out);
+}
+
+void unpack_delta_sse2(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t step, std::uint32_t* out) {
+  unpack_delta_sse2_by_bits[bits](in, base, step, out);
+}
+
+// SSE2 has no variable shuffle (pshufb is SSSE3) and no crc32 (SSE4.2), so compress and crc32c stay
+// scalar here
+const kernels sse2_kernels = {isa::sse2, &sum_sse2, &reverse_sse2, &mismatch_sse2, &fill_sse2, &find_sse2,
+                              &compress_scalar, &unpack_for_sse2, &unpack_delta_sse2, &crc32c_scalar};
+
+
+// AVX2 (8 lanes)
+__attribute__((target("avx2")))
+std::int64_t sum_avx2(const std::int32_t* p, std::size_t n) {
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+    acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+  }
+  alignas(32) std::int64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void reverse_avx2(std::int32_t* p, std::size_t n) {
+  const __m256i rev = _mm256_setr_epi32(7,6,5,4,3,2,1,0);
+  std::size_t lo = 0, hi = n;
+  while (hi - lo >= 16)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + lo));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + hi - 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + lo), _mm256_permutevar8x32_epi32(b, rev));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + hi - 8), _mm256_permutevar8x32_epi32(a, rev));
+    lo += 8;
+    hi -= 8;
+  }
+  reverse_sse2(p + lo, hi - lo);
+}
+
+__attribute__((target("avx2")))
+std::size_t mismatch_avx2(const std::int32_t* a, const std::int32_t* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    unsigned mask = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y))));
+    if (mask != 0xFF) return i + unsigned(__builtin_ctz(~mask));
+  }
+  return i + mismatch_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void fill_avx2(std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m256i v = _mm256_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + i), v);
+  fill_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+std::size_t find_avx2(const std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m256i v = _mm256_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    unsigned mask = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, v))));
+    if (mask) return i + unsigned(__builtin_ctz(mask));
+  }
+  return i + find_scalar(p + i, n - i, value);
+}
+
+// lanes[keep] lists the lanes set in the 8 bit mask keep, lowest first: the permutation that packs them
+struct compress_lut {
+  alignas(32) std::uint32_t lanes[256][8];
+};
+
+constexpr compress_lut make_compress_lut() {
+  compress_lut t {};
+  for (unsigned keep = 0; keep < 256; ++keep)
+  {
+    unsigned k = 0;
+    for (unsigned lane = 0; lane < 8; ++lane)
+      if (keep & (1u << lane)) t.lanes[keep][k++] = lane;
+  }
+  return t;
+}
+
+constexpr compress_lut avx2_compress_lut = make_compress_lut();
+
+// all 8 lanes are stored at dst + w, the ones past the kept count are overwritten by the next store
+__attribute__((target("avx2,popcnt")))
+std::size_t compress_avx2(const std::int32_t* src, std::size_t n, const std::uint64_t* remove, std::int32_t* dst) {
+  std::size_t w = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    unsigned keep = ~unsigned(remove[i / 64] >> (i % 64)) & 0xFF;
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(avx2_compress_lut.lanes[keep]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + w), _mm256_permutevar8x32_epi32(x, perm));
+    w += unsigned(__builtin_popcount(keep));
+  }
+  for (; i < n; ++i)
+  {
+    dst[w] = src[i];
+    w += ((remove[i / 64] >> (i % 64)) & 1) ^ 1;
+  }
+  return w;
+}
+
+// the crc32 instruction (SSE4.2, which detect() requires for the avx2 table), 8 bytes at a time
+__attribute__((target("sse4.2")))
+std::uint32_t crc32c_sse42(std::uint32_t crc, const void* p, std::size_t n) {
+  const unsigned char* b = static_cast<const unsigned char*>(p);
+  std::uint64_t c = ~crc;
+  for (; n >= 8; n -= 8, b += 8)
+  {
+    std::uint64_t word;
+    std::memcpy(&word, b, 8);
+    c = _mm_crc32_u64(c, word);
+  }
+  std::uint32_t c32 = std::uint32_t(c);
+  for (; n > 0; --n, ++b) c32 = _mm_crc32_u8(c32, *b);
+  return ~c32;
+}
+
+// the packed blocks are 4 lanes wide, so they are decoded 128 bits at a time at every isa
+const kernels avx2_kernels = {isa::avx2, &sum_avx2, &reverse_avx2, &mismatch_avx2, &fill_avx2, &find_avx2,
+                              &compress_avx2, &unpack_for_sse2, &unpack_delta_sse2, &crc32c_sse42};
+
+
+// AVX-512 (16 lanes, masked tails instead of scalar loops)
+// GCC's own avx512fintrin.h trips -Wuninitialized on its _mm512_undefined_* placeholders
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+std::int64_t sum_avx512(const std::int32_t* p, std::size_t n) {
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m512i x = _mm512_loadu_si512(p + i);
+    acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+    acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+  }
+  if (i < n)
+  {
+    __mmask16 tail = __mmask16((1u << (n - i)) - 1);
+    __m512i x = _mm512_maskz_loadu_epi32(tail, p + i);
+    acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+    acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+  }
+  return _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+void reverse_avx512(std::int32_t* p, std::size_t n) {
+  const __m512i rev = _mm512_setr_epi32(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+  std::size_t lo = 0, hi = n;
+  while (hi - lo >= 32)
+  {
+    __m512i a = _mm512_loadu_si512(p + lo);
+    __m512i b = _mm512_loadu_si512(p + hi - 16);
+    _mm512_storeu_si512(p + lo, _mm512_permutexvar_epi32(rev, b));
+    _mm512_storeu_si512(p + hi - 16, _mm512_permutexvar_epi32(rev, a));
+    lo += 16;
+    hi -= 16;
+  }
+  reverse_avx2(p + lo, hi - lo);
+}
+
+__attribute__((target("avx512f")))
+std::size_t mismatch_avx512(const std::int32_t* a, const std::int32_t* b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __mmask16 ne = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    if (ne) return i + unsigned(__builtin_ctz(ne));
+  }
+  if (i < n)
+  {
+    __mmask16 tail = __mmask16((1u << (n - i)) - 1);
+    __mmask16 ne = _mm512_mask_cmpneq_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, a + i),
+                                                 _mm512_maskz_loadu_epi32(tail, b + i));
+    if (ne) return i + unsigned(__builtin_ctz(ne));
+  }
+  return n;
+}
+
+__attribute__((target("avx512f")))
+void fill_avx512(std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m512i v = _mm512_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) _mm512_storeu_si512(p + i, v);
+  if (i < n) _mm512_mask_storeu_epi32(p + i, __mmask16((1u << (n - i)) - 1), v);
+}
+
+__attribute__((target("avx512f")))
+std::size_t find_avx512(const std::int32_t* p, std::size_t n, std::int32_t value) {
+  __m512i v = _mm512_set1_epi32(value);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __mmask16 eq = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(p + i), v);
+    if (eq) return i + unsigned(__builtin_ctz(eq));
+  }
+  if (i < n)
+  {
+    __mmask16 tail = __mmask16((1u << (n - i)) - 1);
+    __mmask16 eq = _mm512_mask_cmpeq_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, p + i), v);
+    if (eq) return i + unsigned(__builtin_ctz(eq));
+  }
+  return n;
+}
+
+// vpcompressd stores only the kept lanes
+__attribute__((target("avx512f,popcnt")))
+std::size_t compress_avx512(const std::int32_t* src, std::size_t n, const std::uint64_t* remove, std::int32_t* dst) {
+  std::size_t w = 0;
+  for (std::size_t i = 0; i < n; i += 16)
+  {
+    __mmask16 valid = n - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - i)) - 1);
+    __mmask16 keep = __mmask16(~unsigned(remove[i / 64] >> (i % 64)) & valid);
+    __m512i x = _mm512_maskz_loadu_epi32(valid, src + i);
+    _mm512_mask_compressstoreu_epi32(dst + w, keep, x);
+    w += unsigned(__builtin_popcount(keep));
+  }
+  return w;
+}
+
+const kernels avx512_kernels = {isa::avx512, &sum_avx512, &reverse_avx512, &mismatch_avx512, &fill_avx512, &find_avx512,
+                                &compress_avx512, &unpack_for_sse2, &unpack_delta_sse2, &crc32c_sse42};
+#pragma GCC diagnostic pop
+
+#endif // SIMD_KERNELS_X86
+
+
+isa detect() noexcept {
+  isa best = isa::scalar;
+#if defined(SIMD_KERNELS_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) best = isa::sse2;
+  // the avx2 and avx512 tables also use crc32 (SSE4.2) and popcnt
+  if (!__builtin_cpu_supports("sse4.2") || !__builtin_cpu_supports("popcnt")) return best;
+  if (__builtin_cpu_supports("avx2")) best = isa::avx2;
+  if (__builtin_cpu_supports("avx512f")) best = isa::avx512;
+#endif
+  return best;
+}
+
+isa cap_from_environment(isa best) noexcept {
+  const char* env = std::getenv("VECTORS_SIMD");
+  if (!env) return best;
+  for (isa i : {isa::scalar, isa::sse2, isa::avx2, isa::avx512})
+    if (std::strcmp(env, isa_name(i)) == 0 && i < best) return i;
+  return best;
+}
+
+} // namespace
+
+
+const char* isa_name(isa i) noexcept {
+  switch (i) {
+    case isa::scalar: return "scalar";
+    case isa::sse2: return "sse2";
+    case isa::avx2: return "avx2";
+    case isa::avx512: return "avx512";
+  }
+  return "unknown";
+}
+
+bool supported(isa i) noexcept {
+  static const isa best = detect();
+  return i <= best;
+}
+
+isa detected_isa() noexcept {
+  static const isa chosen = cap_from_environment(detect());
+  return chosen;
+}
+
+const kernels& kernels_for(isa i) noexcept {
+#if defined(SIMD_KERNELS_X86)
+  if (i >= isa::avx512 && supported(isa::avx512)) return avx512_kernels;
+  if (i >= isa::avx2 && supported(isa::avx2)) return avx2_kernels;
+  if (i >= isa::sse2 && supported(isa::sse2)) return sse2_kernels;
+#else
+  (void)i;
+#endif
+  return scalar_kernels;
+}
+
+const kernels& active() noexcept {
+  static const kernels& chosen = kernels_for(detected_isa());
+  return chosen;
+}
+
+} // namespace simd
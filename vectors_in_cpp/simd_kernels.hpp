@@ -0,0 +1,120 @@
+//
+//  simd_kernels.hpp
+//  vectors_in_cpp
+//
+// What?
+// Bulk kernels over contiguous ints, the primitives main.cpp spells out as loops:
+// - sum()     the pop_back loops of vec_empty / vec_pop_back
+// - reverse() the operator[] swap loop of vec_at_op
+// - equal(), compare() operator== and operator< (lexicographical compare) of the relational section
+// - fill()    assign(7,100)
+// - find()    first index of a value
+// - compress() the erase-remove compaction: keep the elements whose bit in a removal bitmask is clear
+// - unpack_for(), unpack_delta() decode one bit-packed block of compressed_vector
+// - crc32c()  the CRC-32C (Castagnoli) checksum of a byte range, for vector_io frames
+// There is one table of kernels per isa, and the widest table the CPU supports is picked once at runtime:
+// - scalar : plain loops (crc32c through a lookup table)
+// - sse2   : SSE2 kernels; compress and crc32c stay scalar
+// - avx2   : AVX2 kernels (compress also needs popcnt); unpack is the SSE2 one, crc32c uses SSE4.2
+// - avx512 : AVX-512F kernels (compress also needs popcnt); unpack is the SSE2 one, crc32c uses SSE4.2
+// The avx2 and avx512 tables are only chosen when the CPU also has SSE4.2 and popcnt.
+//
+// How?
+// - std::int64_t total = simd::sum(vec.data(), vec.size());
+// - simd::reverse(vec);                        // any contiguous container of int
+// - simd::kernels_for(simd::isa::scalar).sum(p, n);   // a specific implementation, e.g. to verify
+// The VECTORS_SIMD environment variable (scalar, sse2, avx2, avx512) caps the runtime choice.
+// Built from simd_kernels.cpp; the vector code paths only exist for x86 with GCC or Clang.
+
+#ifndef simd_kernels_hpp
+#define simd_kernels_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace simd {
+
+enum class isa { scalar, sse2, avx2, avx512 };
+
+const char* isa_name(isa i) noexcept;
+// compiled in and supported by this CPU (and OS)
+bool supported(isa i) noexcept;
+// the widest supported isa, capped by VECTORS_SIMD
+isa detected_isa() noexcept;
+
+struct kernels {
+  isa id;
+  // sum of all elements, accumulated in 64 bits so it cannot overflow
+  std::int64_t (*sum)(const std::int32_t* p, std::size_t n);
+  void (*reverse)(std::int32_t* p, std::size_t n);
+  // index of the first position where a and b differ, n if none
+  std::size_t (*mismatch)(const std::int32_t* a, const std::int32_t* b, std::size_t n);
+  void (*fill)(std::int32_t* p, std::size_t n, std::int32_t value);
+  // index of the first element equal to value, n if none
+  std::size_t (*find)(const std::int32_t* p, std::size_t n, std::int32_t value);
+  // Copies src[i] for every i whose bit i (bit i % 64 of remove[i / 64]) is clear to dst, in order, and
+  // returns how many were kept. dst needs room for n elements; dst == src compacts in place.
+  std::size_t (*compress)(const std::int32_t* src, std::size_t n, const std::uint64_t* remove, std::int32_t* dst);
+  // Decode a block of 128 values packed bits (0..32) wide in the 4-lane layout of compressed_vector:
+  // value j is in lane j % 4 at position j / 4, and lane l's bit stream is in words l, l + 4, l + 8 ...
+  // (4 * bits words in all). unpack_for writes base + value_j, unpack_delta the running sum
+  // base + (value_0 + step) + ... + (value_j + step). Arithmetic wraps modulo 2^32.
+  void (*unpack_for)(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t* out);
+  void (*unpack_delta)(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t step, std::uint32_t* out);
+  // CRC-32C of n bytes continuing from crc (0 to start); crc32c(crc32c(0, a, n), b, m) is the CRC of a then b
+  std::uint32_t (*crc32c)(std::uint32_t crc, const void* p, std::size_t n);
+};
+
+// the table for one isa; unsupported ones fall back to the next narrower supported implementation
+const kernels& kernels_for(isa i) noexcept;
+// the table for detected_isa()
+const kernels& active() noexcept;
+
+inline std::int64_t sum(const std::int32_t* p, std::size_t n) { return active().sum(p, n); }
+inline void reverse(std::int32_t* p, std::size_t n) { active().reverse(p, n); }
+inline std::size_t mismatch(const std::int32_t* a, const std::int32_t* b, std::size_t n) { return active().mismatch(a, b, n); }
+inline void fill(std::int32_t* p, std::size_t n, std::int32_t value) { active().fill(p, n, value); }
+inline std::size_t find(const std::int32_t* p, std::size_t n, std::int32_t value) { return active().find(p, n, value); }
+inline std::size_t compress(const std::int32_t* src, std::size_t n, const std::uint64_t* remove, std::int32_t* dst) {
+  return active().compress(src, n, remove, dst);
+}
+inline void unpack_for(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t* out) {
+  active().unpack_for(in, bits, base, out);
+}
+inline void unpack_delta(const std::uint32_t* in, unsigned bits, std::uint32_t base, std::uint32_t step, std::uint32_t* out) {
+  active().unpack_delta(in, bits, base, step, out);
+}
+inline std::uint32_t crc32c(std::uint32_t crc, const void* p, std::size_t n) { return active().crc32c(crc, p, n); }
+
+inline bool equal(const std::int32_t* a, std::size_t na, const std::int32_t* b, std::size_t nb) {
+  return na == nb && mismatch(a, b, na) == na;
+}
+// lexicographical compare like std::vector's operator<: negative, zero or positive
+inline int compare(const std::int32_t* a, std::size_t na, const std::int32_t* b, std::size_t nb) {
+  std::size_t n = na < nb ? na : nb;
+  std::size_t i = mismatch(a, b, n);
+  if (i < n) return a[i] < b[i] ? -1 : 1;
+  return na < nb ? -1 : (na > nb ? 1 : 0);
+}
+
+// Overloads for contiguous containers of int (std::vector<int>, small_vector<int, N> ...)
+template <class Vec>
+using require_int_vector = std::enable_if_t<std::is_same<typename Vec::value_type, std::int32_t>::value>;
+
+template <class Vec, class = require_int_vector<Vec>>
+std::int64_t sum(const Vec& v) { return sum(v.data(), v.size()); }
+template <class Vec, class = require_int_vector<Vec>>
+void reverse(Vec& v) { reverse(v.data(), v.size()); }
+template <class Vec, class = require_int_vector<Vec>>
+bool equal(const Vec& a, const Vec& b) { return equal(a.data(), a.size(), b.data(), b.size()); }
+template <class Vec, class = require_int_vector<Vec>>
+bool less(const Vec& a, const Vec& b) { return compare(a.data(), a.size(), b.data(), b.size()) < 0; }
+template <class Vec, class = require_int_vector<Vec>>
+void fill(Vec& v, std::int32_t value) { fill(v.data(), v.size(), value); }
+template <class Vec, class = require_int_vector<Vec>>
+std::size_t find(const Vec& v, std::int32_t value) { return find(v.data(), v.size(), value); }
+
+} // namespace simd
+
+#endif /* simd_kernels_hpp */
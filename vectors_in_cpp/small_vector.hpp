@@ -0,0 +1,402 @@
+//
+//  small_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// small_vector<T, N> is a sequence container with the std::vector interface that keeps up to N elements
+// inside the object itself (inline storage) and only allocates on the heap once it grows past N
+// Most vectors in main.cpp hold 3 to 10 ints, so with N = 16 none of them touches the allocator
+//
+// How?
+// Declaration :
+// - small_vector<int, 8> vec1 = {1,2,3}; // inline, no allocation
+// - small_vector<int, 2> vec2 {1,2,3};   // 3 > N, spills to the heap
+// Differences from std::vector :
+// - iterators, references and pointers are invalidated by swap() and move construction/assignment
+//   while the elements are inline (they have to be moved, there is no buffer to hand over)
+// - shrink_to_fit() moves the elements back inline when size() <= N
+// - capacity() is never smaller than N
+
+#ifndef small_vector_hpp
+#define small_vector_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template <class T, std::size_t N>
+class small_vector {
+  template <class It>
+  using require_iterator = typename std::iterator_traits<It>::iterator_category;
+  template <class It>
+  using is_forward = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_type inline_capacity = N;
+
+  // constructors
+  small_vector() noexcept : data_(inline_data()), size_(0), capacity_(N) {}
+  explicit small_vector(size_type n) : small_vector() { resize(n); }
+  small_vector(size_type n, const T& value) : small_vector() { assign(n, value); }
+  template <class InputIt, class = require_iterator<InputIt>>
+  small_vector(InputIt first, InputIt last) : small_vector() { assign(first, last); }
+  small_vector(std::initializer_list<T> init) : small_vector() { assign(init.begin(), init.end()); }
+  small_vector(const small_vector& other) : small_vector() { assign(other.begin(), other.end()); }
+  small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : small_vector() {
+    steal(other);
+  }
+
+  ~small_vector() {
+    destroy(data_, data_ + size_);
+    release();
+  }
+
+  // operator=
+  small_vector& operator=(const small_vector& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+  small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+    if (this != &other) {
+      clear();
+      if (!other.is_inline()) release();
+      steal(other);
+    }
+    return *this;
+  }
+  small_vector& operator=(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+    return *this;
+  }
+
+  // assign()
+  void assign(size_type n, const T& value) {
+    T copy(value);   // value may refer to one of our own elements
+    clear();
+    reserve(n);
+    std::uninitialized_fill_n(data_, n, copy);
+    size_ = n;
+  }
+  template <class InputIt, class = require_iterator<InputIt>>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    if constexpr (is_forward<InputIt>::value) {
+      size_type n = size_type(std::distance(first, last));
+      reserve(n);
+      std::uninitialized_copy(first, last, data_);
+      size_ = n;
+    } else {
+      for (; first != last; ++first) emplace_back(*first);
+    }
+  }
+  void assign(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+  // element access
+  reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("small_vector::at");
+    return data_[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("small_vector::at");
+    return data_[i];
+  }
+  reference operator[](size_type i) noexcept { return data_[i]; }
+  const_reference operator[](size_type i) const noexcept { return data_[i]; }
+  reference front() noexcept { return data_[0]; }
+  const_reference front() const noexcept { return data_[0]; }
+  reference back() noexcept { return data_[size_ - 1]; }
+  const_reference back() const noexcept { return data_[size_ - 1]; }
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+
+  // iterators
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type max_size() const noexcept { return std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>()); }
+  size_type capacity() const noexcept { return capacity_; }
+  bool is_inline() const noexcept { return data_ == inline_data(); }
+
+  void reserve(size_type n) {
+    if (n > capacity_) reallocate(n);
+  }
+
+  void shrink_to_fit() {
+    if (is_inline() || size_ == capacity_) return;
+    if (size_ <= N) {
+      T* heap = data_;
+      size_type heap_capacity = capacity_;
+      relocate(heap, heap + size_, inline_data());
+      std::allocator<T>().deallocate(heap, heap_capacity);
+      data_ = inline_data();
+      capacity_ = N;
+    } else {
+      reallocate(size_);
+    }
+  }
+
+  // modifiers
+  void clear() noexcept {
+    destroy(data_, data_ + size_);
+    size_ = 0;
+  }
+
+  iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  iterator insert(const_iterator pos, size_type n, const T& value) {
+    size_type index = size_type(pos - data_);
+    T copy(value);
+    make_room(n);
+    std::uninitialized_fill_n(data_ + size_, n, copy);
+    size_ += n;
+    std::rotate(data_ + index, data_ + size_ - n, data_ + size_);
+    return data_ + index;
+  }
+  template <class InputIt, class = require_iterator<InputIt>>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_type index = size_type(pos - data_);
+    size_type old_size = size_;
+    if constexpr (is_forward<InputIt>::value) {
+      size_type n = size_type(std::distance(first, last));
+      make_room(n);
+      std::uninitialized_copy(first, last, data_ + size_);
+      size_ += n;
+    } else {
+      for (; first != last; ++first) emplace_back(*first);
+    }
+    std::rotate(data_ + index, data_ + old_size, data_ + size_);
+    return data_ + index;
+  }
+  iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    size_type index = size_type(pos - data_);
+    if (size_ == capacity_) return grow_emplace(index, std::forward<Args>(args)...);
+    if (index == size_) {
+      ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+      ++size_;
+      return data_ + index;
+    }
+    T value(std::forward<Args>(args)...);
+    ::new (static_cast<void*>(data_ + size_)) T(std::move(data_[size_ - 1]));
+    ++size_;
+    std::move_backward(data_ + index, data_ + size_ - 2, data_ + size_ - 1);
+    data_[index] = std::move(value);
+    return data_ + index;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    T* f = data_ + (first - data_);
+    T* l = data_ + (last - data_);
+    if (f != l) {
+      T* new_end = std::move(l, data_ + size_, f);
+      destroy(new_end, data_ + size_);
+      size_ = size_type(new_end - data_);
+    }
+    return f;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    if (size_ == capacity_) return *grow_emplace(size_, std::forward<Args>(args)...);
+    ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+
+  void pop_back() noexcept {
+    --size_;
+    data_[size_].~T();
+  }
+
+  void resize(size_type n) {
+    if (n < size_) {
+      destroy(data_ + n, data_ + size_);
+    } else {
+      reserve(n);
+      std::uninitialized_value_construct(data_ + size_, data_ + n);
+    }
+    size_ = n;
+  }
+  void resize(size_type n, const T& value) {
+    if (n < size_) {
+      destroy(data_ + n, data_ + size_);
+      size_ = n;
+    } else if (n > size_) {
+      T copy(value);
+      reserve(n);
+      std::uninitialized_fill(data_ + size_, data_ + n, copy);
+      size_ = n;
+    }
+  }
+
+  void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+    if (this == &other) return;
+    if (!is_inline() && !other.is_inline()) {
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(capacity_, other.capacity_);
+      return;
+    }
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  // relational operators
+  friend bool operator==(const small_vector& lhs, const small_vector& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+  friend bool operator!=(const small_vector& lhs, const small_vector& rhs) { return !(lhs == rhs); }
+  friend bool operator<(const small_vector& lhs, const small_vector& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  friend bool operator>(const small_vector& lhs, const small_vector& rhs) { return rhs < lhs; }
+  friend bool operator<=(const small_vector& lhs, const small_vector& rhs) { return !(rhs < lhs); }
+  friend bool operator>=(const small_vector& lhs, const small_vector& rhs) { return !(lhs < rhs); }
+
+  friend void swap(small_vector& lhs, small_vector& rhs) noexcept(noexcept(lhs.swap(rhs))) { lhs.swap(rhs); }
+
+private:
+  T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(inline_)); }
+  const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_)); }
+
+  static void destroy(T* first, T* last) noexcept { std::destroy(first, last); }
+
+  // move [first, last) into uninitialized storage at out and destroy the originals
+  static void relocate(T* first, T* last, T* out) {
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if (first != last) std::memmove(static_cast<void*>(out), static_cast<const void*>(first), size_type(last - first) * sizeof(T));
+    } else {
+      std::uninitialized_move(first, last, out);
+      destroy(first, last);
+    }
+  }
+
+  size_type grown_capacity(size_type needed) const noexcept { return std::max(capacity_ * 2, needed); }
+
+  // capacity for n more elements, growing geometrically like push_back does
+  void make_room(size_type n) {
+    if (size_ + n > capacity_) reallocate(grown_capacity(size_ + n));
+  }
+
+  // no room left: build the new element in the new buffer first, since the arguments may refer to old elements
+  template <class... Args>
+  T* grow_emplace(size_type index, Args&&... args) {
+    size_type new_capacity = grown_capacity(size_ + 1);
+    T* buffer = std::allocator<T>().allocate(new_capacity);
+    try {
+      ::new (static_cast<void*>(buffer + index)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      std::allocator<T>().deallocate(buffer, new_capacity);
+      throw;
+    }
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      relocate(data_, data_ + index, buffer);
+      relocate(data_ + index, data_ + size_, buffer + index + 1);
+    } else {
+      // the originals are destroyed only once both halves have moved, so a throwing move leaves
+      // *this as it was (moved-from elements aside) and frees the new buffer
+      try {
+        std::uninitialized_move(data_, data_ + index, buffer);
+        try {
+          std::uninitialized_move(data_ + index, data_ + size_, buffer + index + 1);
+        } catch (...) {
+          destroy(buffer, buffer + index);
+          throw;
+        }
+      } catch (...) {
+        buffer[index].~T();
+        std::allocator<T>().deallocate(buffer, new_capacity);
+        throw;
+      }
+      destroy(data_, data_ + size_);
+    }
+    release();
+    data_ = buffer;
+    capacity_ = new_capacity;
+    ++size_;
+    return data_ + index;
+  }
+
+  void reallocate(size_type new_capacity) {
+    T* buffer = std::allocator<T>().allocate(new_capacity);
+    try {
+      relocate(data_, data_ + size_, buffer);
+    } catch (...) {
+      std::allocator<T>().deallocate(buffer, new_capacity);
+      throw;
+    }
+    release();
+    data_ = buffer;
+    capacity_ = new_capacity;
+  }
+
+  // free the heap buffer (if any) without touching the elements
+  void release() noexcept {
+    if (!is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+    data_ = inline_data();
+    capacity_ = N;
+  }
+
+  // take other's elements and leave other empty; *this must be empty, and inline if other is on the heap
+  void steal(small_vector& other) {
+    if (other.is_inline()) {
+      relocate(other.data_, other.data_ + other.size_, data_);
+      size_ = other.size_;
+      other.size_ = 0;
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_data();
+      other.size_ = 0;
+      other.capacity_ = N;
+    }
+  }
+
+  T* data_;
+  size_type size_;
+  size_type capacity_;
+  alignas(T) unsigned char inline_[(N ? N : 1) * sizeof(T)];
+};
+
+#endif /* small_vector_hpp */
@@ -0,0 +1,433 @@
+//
+//  soa_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// soa_vector<Fields...> is a vector of records stored as a structure of arrays: every field has its
+// own contiguous column, so a loop over one or two fields only pulls those fields through the cache,
+// where std::vector<record> drags every field of every record along
+// - the modifiers of main.cpp: push_back, emplace_back, insert, erase, resize, pop_back, clear, swap
+// - column<I>() / data<I>() : field I of every record, contiguous and 64-byte aligned, ready for
+//   SIMD kernels (e.g. simd::sum(v.data<0>(), v.size()))
+// - v[i] / *it               : a std::tuple of references to the fields of record i
+//
+// How?
+// - soa_vector<double, double, int> points;      // x, y, id
+// - points.emplace_back(1.0, 2.0, 7);            // one argument per field
+// - points.push_back({3.0, 4.0, 8});             // a std::tuple<double, double, int>
+// - for (double x : points.column<0>()) ...      // scan one field
+// - std::get<2>(points[1]) = 9;  or  points.get<2>(1) = 9;
+//
+// All columns live in one allocation and grow together (doubling). Fields must be nothrow movable;
+// any operation that copies or constructs fields builds the new ones at the end of every column
+// first and rotates them into place, so a throwing field leaves the vector as it was.
+
+#ifndef soa_vector_hpp
+#define soa_vector_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+template <class... Fields>
+class soa_vector {
+  static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+  static_assert((std::is_nothrow_move_constructible<Fields>::value && ...) &&
+                (std::is_nothrow_move_assignable<Fields>::value && ...),
+                "soa_vector fields must be nothrow movable");
+  static_assert(((alignof(Fields) <= 64) && ...), "soa_vector columns are 64-byte aligned");
+
+  static constexpr std::size_t field_count = sizeof...(Fields);
+  static constexpr std::size_t column_alignment = 64;
+  using indices = std::make_index_sequence<field_count>;
+
+public:
+  using value_type = std::tuple<Fields...>;
+  using reference = std::tuple<Fields&...>;
+  using const_reference = std::tuple<const Fields&...>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  template <std::size_t I>
+  using field_type = std::tuple_element_t<I, value_type>;
+
+  // one column as a contiguous range
+  template <class T>
+  struct column_view {
+    T* first;
+    T* last;
+    T* begin() const noexcept { return first; }
+    T* end() const noexcept { return last; }
+    T* data() const noexcept { return first; }
+    std::size_t size() const noexcept { return std::size_t(last - first); }
+    T& operator[](std::size_t i) const noexcept { return first[i]; }
+  };
+
+private:
+  template <bool Const>
+  class basic_iterator {
+    using owner_type = std::conditional_t<Const, const soa_vector, soa_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = soa_vector::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, soa_vector::const_reference, soa_vector::reference>;
+    using pointer = void;
+
+    basic_iterator() noexcept = default;
+    basic_iterator(owner_type* owner, std::size_t i) noexcept : owner_(owner), i_(i) {}
+    operator basic_iterator<true>() const noexcept { return {owner_, i_}; }
+
+    reference operator*() const noexcept { return (*owner_)[i_]; }
+    reference operator[](difference_type d) const noexcept { return (*owner_)[i_ + std::size_t(d)]; }
+    std::size_t index() const noexcept { return i_; }
+
+    basic_iterator& operator++() noexcept { ++i_; return *this; }
+    basic_iterator operator++(int) noexcept { basic_iterator t = *this; ++i_; return t; }
+    basic_iterator& operator--() noexcept { --i_; return *this; }
+    basic_iterator operator--(int) noexcept { basic_iterator t = *this; --i_; return t; }
+    basic_iterator& operator+=(difference_type d) noexcept { i_ += std::size_t(d); return *this; }
+    basic_iterator& operator-=(difference_type d) noexcept { i_ -= std::size_t(d); return *this; }
+    friend basic_iterator operator+(basic_iterator it, difference_type d) noexcept { return it += d; }
+    friend basic_iterator operator+(difference_type d, basic_iterator it) noexcept { return it += d; }
+    friend basic_iterator operator-(basic_iterator it, difference_type d) noexcept { return it -= d; }
+    friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) noexcept {
+      return difference_type(a.i_) - difference_type(b.i_);
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ == b.i_; }
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ != b.i_; }
+    friend bool operator<(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ < b.i_; }
+    friend bool operator>(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ > b.i_; }
+    friend bool operator<=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ <= b.i_; }
+    friend bool operator>=(const basic_iterator& a, const basic_iterator& b) noexcept { return a.i_ >= b.i_; }
+
+  private:
+    owner_type* owner_ = nullptr;
+    std::size_t i_ = 0;
+  };
+
+public:
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  soa_vector() noexcept = default;
+  explicit soa_vector(size_type n) { resize(n); }
+  soa_vector(size_type n, const value_type& value) { resize(n, value); }
+  soa_vector(std::initializer_list<value_type> init) {
+    reserve(init.size());
+    for (const value_type& x : init) push_back(x);
+  }
+  soa_vector(const soa_vector& other) {
+    reserve(other.size_);
+    for (size_type i = 0; i < other.size_; ++i) push_back(other.record(i, indices()));
+  }
+  soa_vector(soa_vector&& other) noexcept { swap(other); }
+  ~soa_vector() {
+    clear();
+    ::operator delete(block_, std::align_val_t(column_alignment));
+  }
+
+  soa_vector& operator=(const soa_vector& other) {
+    if (this != &other) soa_vector(other).swap(*this);
+    return *this;
+  }
+  soa_vector& operator=(soa_vector&& other) noexcept {
+    soa_vector(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  // columns
+  template <std::size_t I>
+  field_type<I>* data() noexcept { return std::get<I>(columns_); }
+  template <std::size_t I>
+  const field_type<I>* data() const noexcept { return std::get<I>(columns_); }
+  template <std::size_t I>
+  column_view<field_type<I>> column() noexcept { return {data<I>(), data<I>() + size_}; }
+  template <std::size_t I>
+  column_view<const field_type<I>> column() const noexcept { return {data<I>(), data<I>() + size_}; }
+
+  // element access
+  template <std::size_t I>
+  field_type<I>& get(size_type i) noexcept { return data<I>()[i]; }
+  template <std::size_t I>
+  const field_type<I>& get(size_type i) const noexcept { return data<I>()[i]; }
+  reference operator[](size_type i) noexcept { return refs(i, indices()); }
+  const_reference operator[](size_type i) const noexcept { return crefs(i, indices()); }
+  reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("soa_vector::at");
+    return (*this)[i];
+  }
+  const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("soa_vector::at");
+    return (*this)[i];
+  }
+  reference front() noexcept { return (*this)[0]; }
+  const_reference front() const noexcept { return (*this)[0]; }
+  reference back() noexcept { return (*this)[size_ - 1]; }
+  const_reference back() const noexcept { return (*this)[size_ - 1]; }
+
+  // iterators
+  iterator begin() noexcept { return {this, 0}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator cbegin() const noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+  const_iterator cend() const noexcept { return {this, size_}; }
+
+  // capacity
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type capacity() const noexcept { return capacity_; }
+  size_type max_size() const noexcept {
+    return std::numeric_limits<size_type>::max() / (sizeof(Fields) + ...) / 2;
+  }
+  void reserve(size_type n) {
+    if (n > capacity_) reallocate(n);
+  }
+  void shrink_to_fit() {
+    if (size_ < capacity_) reallocate(size_);
+  }
+
+  // modifiers
+  void clear() noexcept {
+    destroy_from(0, indices());
+    size_ = 0;
+  }
+
+  void push_back(const value_type& value) { emplace_back_tuple(value, indices()); }
+  void push_back(value_type&& value) { emplace_back_tuple(std::move(value), indices()); }
+
+  // one argument per field
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    static_assert(sizeof...(Args) == field_count, "soa_vector::emplace_back takes one argument per field");
+    if (size_ == capacity_)
+    {
+      // the arguments may refer to fields of this vector, build the record before the columns move
+      value_type value(std::forward<Args>(args)...);
+      reallocate(next_capacity(size_ + 1));
+      construct_at_end(indices(), std::move(value));
+    }
+    else
+    {
+      construct_fields(size_, indices(), std::forward<Args>(args)...);
+    }
+    ++size_;
+    return back();
+  }
+
+  void pop_back() noexcept { truncate(size_ - 1); }
+
+  iterator insert(const_iterator pos, const value_type& value) { return insert(pos, 1, value); }
+  iterator insert(const_iterator pos, value_type&& value) {
+    size_type at = pos.index();
+    push_back(std::move(value));
+    rotate_into(at, size_ - 1);
+    return {this, at};
+  }
+  iterator insert(const_iterator pos, size_type n, const value_type& value) {
+    size_type at = pos.index();
+    size_type old_size = size_;
+    append_copies(n, value);
+    rotate_into(at, old_size);
+    return {this, at};
+  }
+  template <class It, class = typename std::iterator_traits<It>::iterator_category>
+  iterator insert(const_iterator pos, It first, It last) {
+    size_type at = pos.index();
+    size_type old_size = size_;
+    try
+    {
+      for (; first != last; ++first) push_back(*first);
+    }
+    catch (...)
+    {
+      truncate(old_size);
+      throw;
+    }
+    rotate_into(at, old_size);
+    return {this, at};
+  }
+  iterator insert(const_iterator pos, std::initializer_list<value_type> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    size_type from = first.index();
+    size_type count = last.index() - from;
+    if (count > 0)
+    {
+      erase_columns(from, count, indices());
+      truncate(size_ - count);
+    }
+    return {this, from};
+  }
+
+  void resize(size_type n) {
+    if (n <= size_) truncate(n);
+    else append_copies(n - size_, value_type());
+  }
+  void resize(size_type n, const value_type& value) {
+    if (n <= size_) truncate(n);
+    else append_copies(n - size_, value);
+  }
+
+  void swap(soa_vector& other) noexcept {
+    std::swap(block_, other.block_);
+    std::swap(columns_, other.columns_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+  }
+  friend void swap(soa_vector& a, soa_vector& b) noexcept { a.swap(b); }
+
+  friend bool operator==(const soa_vector& a, const soa_vector& b) {
+    return a.size_ == b.size_ && a.equal_columns(b, indices());
+  }
+  friend bool operator!=(const soa_vector& a, const soa_vector& b) { return !(a == b); }
+
+private:
+  size_type next_capacity(size_type needed) const noexcept { return std::max<size_type>({needed, 8, capacity_ * 2}); }
+
+  template <std::size_t... I>
+  reference refs(size_type i, std::index_sequence<I...>) noexcept { return reference(std::get<I>(columns_)[i]...); }
+  template <std::size_t... I>
+  const_reference crefs(size_type i, std::index_sequence<I...>) const noexcept {
+    return const_reference(std::get<I>(columns_)[i]...);
+  }
+  template <std::size_t... I>
+  value_type record(size_type i, std::index_sequence<I...>) const { return value_type(std::get<I>(columns_)[i]...); }
+
+  // builds field I of slot i from args, unwinding the fields already built if one throws
+  template <std::size_t... I, class... Args>
+  void construct_fields(size_type i, std::index_sequence<I...>, Args&&... args) {
+    std::size_t built = 0;
+    try
+    {
+      ((::new (static_cast<void*>(std::get<I>(columns_) + i)) Fields(std::forward<Args>(args)), ++built), ...);
+    }
+    catch (...)
+    {
+      ((I < built ? std::get<I>(columns_)[i].~Fields() : void()), ...);
+      throw;
+    }
+  }
+
+  template <class Tuple, std::size_t... I>
+  void emplace_back_tuple(Tuple&& value, std::index_sequence<I...>) {
+    emplace_back(std::get<I>(std::forward<Tuple>(value))...);
+  }
+
+  template <std::size_t... I>
+  void construct_at_end(std::index_sequence<I...>, value_type&& value) noexcept {
+    (::new (static_cast<void*>(std::get<I>(columns_) + size_)) Fields(std::move(std::get<I>(value))), ...);
+  }
+
+  // n copies of value at the end, all or nothing
+  void append_copies(size_type n, const value_type& value) {
+    if (n == 0) return;
+    if (size_ + n > capacity_)
+    {
+      value_type copy = value;   // value may refer to this vector
+      reallocate(std::max(size_ + n, next_capacity(size_ + n)));
+      return append_copies(n, copy);
+    }
+    size_type old_size = size_;
+    try
+    {
+      for (; size_ < old_size + n; ++size_) copy_fields(size_, value, indices());
+    }
+    catch (...)
+    {
+      truncate(old_size);
+      throw;
+    }
+  }
+
+  template <std::size_t... I>
+  void copy_fields(size_type i, const value_type& value, std::index_sequence<I...> is) {
+    construct_fields(i, is, std::get<I>(value)...);
+  }
+
+  // moves the records [from, size_) to position at, the ones in between after them
+  void rotate_into(size_type at, size_type from) noexcept { rotate_columns(at, from, indices()); }
+  template <std::size_t... I>
+  void rotate_columns(size_type at, size_type from, std::index_sequence<I...>) noexcept {
+    if (at == from || from == size_) return;
+    (std::rotate(std::get<I>(columns_) + at, std::get<I>(columns_) + from, std::get<I>(columns_) + size_), ...);
+  }
+
+  template <std::size_t... I>
+  void erase_columns(size_type from, size_type count, std::index_sequence<I...>) noexcept {
+    (std::move(std::get<I>(columns_) + from + count, std::get<I>(columns_) + size_, std::get<I>(columns_) + from), ...);
+  }
+
+  void truncate(size_type n) noexcept {
+    destroy_from(n, indices());
+    size_ = n;
+  }
+
+  template <std::size_t... I>
+  void destroy_from(size_type n, std::index_sequence<I...>) noexcept {
+    (std::destroy(std::get<I>(columns_) + n, std::get<I>(columns_) + size_), ...);
+  }
+
+  template <std::size_t... I>
+  bool equal_columns(const soa_vector& other, std::index_sequence<I...>) const {
+    return (std::equal(std::get<I>(columns_), std::get<I>(columns_) + size_, std::get<I>(other.columns_)) && ...);
+  }
+
+  // column k starts at a multiple of 64 bytes after column k - 1
+  static size_type block_bytes(size_type capacity) noexcept {
+    size_type bytes = 0;
+    ((bytes = round_up(bytes + capacity * sizeof(Fields))), ...);
+    return bytes;
+  }
+  static size_type round_up(size_type n) noexcept { return (n + column_alignment - 1) / column_alignment * column_alignment; }
+
+  template <std::size_t... I>
+  static std::tuple<Fields*...> carve(char* block, size_type capacity, std::index_sequence<I...>) noexcept {
+    std::tuple<Fields*...> columns;
+    size_type offset = 0;
+    ((std::get<I>(columns) = reinterpret_cast<Fields*>(block + offset),
+      offset = round_up(offset + capacity * sizeof(Fields))), ...);
+    return columns;
+  }
+
+  template <std::size_t... I>
+  void move_columns(std::tuple<Fields*...>& to, std::index_sequence<I...>) noexcept {
+    (std::uninitialized_move(std::get<I>(columns_), std::get<I>(columns_) + size_, std::get<I>(to)), ...);
+    destroy_from(0, indices());
+  }
+
+  void reallocate(size_type new_capacity) {
+    if (new_capacity > max_size()) throw std::length_error("soa_vector");
+    char* block = nullptr;
+    std::tuple<Fields*...> columns {};
+    if (new_capacity > 0)
+    {
+      block = static_cast<char*>(::operator new(block_bytes(new_capacity), std::align_val_t(column_alignment)));
+      columns = carve(block, new_capacity, indices());
+    }
+    move_columns(columns, indices());
+    ::operator delete(block_, std::align_val_t(column_alignment));
+    block_ = block;
+    columns_ = columns;
+    capacity_ = new_capacity;
+  }
+
+  char* block_ = nullptr;
+  std::tuple<Fields*...> columns_ {};
+  size_type size_ = 0;
+  size_type capacity_ = 0;
+};
+
+#endif /* soa_vector_hpp */
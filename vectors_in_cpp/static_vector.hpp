@@ -0,0 +1,299 @@
+//
+//  static_vector.hpp
+//  vectors_in_cpp
+//
+// What?
+// static_vector<T, N> is a vector with a fixed capacity of N elements stored inside the object itself
+// (never on the heap) whose whole interface is constexpr, so small tables such as the int_array or
+// vec_cbegin_cend of main.cpp can be built by the compiler and cost nothing at startup
+// - assign, at, [], front, back, data, begin/end, rbegin/rend (and the c- versions)
+// - insert, emplace, erase, push_back, emplace_back, pop_back, resize, clear, swap
+// - ==, !=, <, <=, >, >=
+// Going past N throws std::length_error; during constant evaluation that is a compile error, as
+// at() out of range is.
+//
+// How?
+// - constexpr static_vector<int, 8> table = {1776, 7, 4};          // in read-only data, no initializer runs
+// - constexpr auto squares = [] { static_vector<int, 16> v; for (int i = 0; i < 16; ++i) v.push_back(i * i); return v; }();
+// - static_assert(squares.at(3) == 9, "");
+//
+// C++17 cannot begin the lifetime of an object inside a constexpr function, so the N slots always
+// hold N objects: T must be default constructible, slots past size() hold T(), and removing an element
+// assigns T() to its slot (a removed std::string frees its buffer, but the object stays). Anything
+// that is not a literal type still works, only not in constant expressions.
+
+#ifndef static_vector_hpp
+#define static_vector_hpp
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace static_vector_detail {
+
+template <class T>
+constexpr void swap(T& a, T& b) {
+  T t = std::move(a);
+  a = std::move(b);
+  b = std::move(t);
+}
+
+template <class T>
+constexpr void reverse(T* first, T* last) {
+  for (; first != last && first != --last; ++first) swap(*first, *last);
+}
+
+// [first, middle) and [middle, last) trade places
+template <class T>
+constexpr void rotate(T* first, T* middle, T* last) {
+  reverse(first, middle);
+  reverse(middle, last);
+  reverse(first, last);
+}
+
+} // namespace static_vector_detail
+
+template <class T, std::size_t N>
+class static_vector {
+  static_assert(std::is_default_constructible<T>::value, "static_vector keeps N constructed slots");
+
+  template <class It>
+  using require_iterator = typename std::iterator_traits<It>::iterator_category;
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static_vector() = default;
+  constexpr explicit static_vector(size_type n) { resize(n); }
+  constexpr static_vector(size_type n, const T& value) { assign(n, value); }
+  template <class It, class = require_iterator<It>>
+  constexpr static_vector(It first, It last) { assign(first, last); }
+  constexpr static_vector(std::initializer_list<T> init) { assign(init); }
+  constexpr static_vector(const static_vector& other) : size_(other.size_) {
+    for (size_type i = 0; i < size_; ++i) data_[i] = other.data_[i];
+  }
+  constexpr static_vector(static_vector&& other) noexcept(std::is_nothrow_move_assignable<T>::value)
+    : size_(other.size_) {
+    for (size_type i = 0; i < size_; ++i) data_[i] = std::move(other.data_[i]);
+  }
+
+  constexpr static_vector& operator=(const static_vector& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+  constexpr static_vector& operator=(static_vector&& other) noexcept(std::is_nothrow_move_assignable<T>::value) {
+    if (this != &other)
+    {
+      for (size_type i = 0; i < other.size_; ++i) data_[i] = std::move(other.data_[i]);
+      reset(other.size_, size_);
+      size_ = other.size_;
+    }
+    return *this;
+  }
+  constexpr static_vector& operator=(std::initializer_list<T> init) {
+    assign(init);
+    return *this;
+  }
+
+  constexpr void assign(size_type n, const T& value) {
+    check_capacity(n);
+    T copy = value;   // value may be an element
+    for (size_type i = 0; i < n; ++i) data_[i] = copy;
+    reset(n, size_);
+    size_ = n;
+  }
+  template <class It, class = require_iterator<It>>
+  constexpr void assign(It first, It last) {
+    clear();
+    for (; first != last; ++first) push_back(*first);
+  }
+  constexpr void assign(std::initializer_list<T> init) { assign(init.begin(), init.end()); }
+
+  // element access
+  constexpr reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("static_vector::at");
+    return data_[i];
+  }
+  constexpr const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("static_vector::at");
+    return data_[i];
+  }
+  constexpr reference operator[](size_type i) noexcept { return data_[i]; }
+  constexpr const_reference operator[](size_type i) const noexcept { return data_[i]; }
+  constexpr reference front() noexcept { return data_[0]; }
+  constexpr const_reference front() const noexcept { return data_[0]; }
+  constexpr reference back() noexcept { return data_[size_ - 1]; }
+  constexpr const_reference back() const noexcept { return data_[size_ - 1]; }
+  constexpr T* data() noexcept { return data_; }
+  constexpr const T* data() const noexcept { return data_; }
+
+  // iterators
+  constexpr iterator begin() noexcept { return data_; }
+  constexpr const_iterator begin() const noexcept { return data_; }
+  constexpr const_iterator cbegin() const noexcept { return data_; }
+  constexpr iterator end() noexcept { return data_ + size_; }
+  constexpr const_iterator end() const noexcept { return data_ + size_; }
+  constexpr const_iterator cend() const noexcept { return data_ + size_; }
+  constexpr reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  constexpr const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+  constexpr const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator(end()); }
+  constexpr reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  constexpr const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+  constexpr const_reverse_iterator crend() const noexcept { return const_reverse_iterator(begin()); }
+
+  // capacity
+  constexpr bool empty() const noexcept { return size_ == 0; }
+  constexpr size_type size() const noexcept { return size_; }
+  static constexpr size_type capacity() noexcept { return N; }
+  static constexpr size_type max_size() noexcept { return N; }
+  // nothing to allocate: only checks that n fits
+  constexpr void reserve(size_type n) const { check_capacity(n); }
+  constexpr void shrink_to_fit() noexcept {}
+
+  // modifiers
+  constexpr void clear() {
+    reset(0, size_);
+    size_ = 0;
+  }
+
+  constexpr iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+  constexpr iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+  constexpr iterator insert(const_iterator pos, size_type n, const T& value) {
+    size_type at = index_of(pos);
+    check_capacity(size_ + n);
+    T copy = value;
+    for (size_type i = 0; i < n; ++i) data_[size_ + i] = copy;
+    size_ += n;
+    static_vector_detail::rotate(data_ + at, data_ + size_ - n, data_ + size_);
+    return data_ + at;
+  }
+  // appended then rotated into place, so single-pass input iterators work too; all or nothing
+  template <class It, class = require_iterator<It>>
+  constexpr iterator insert(const_iterator pos, It first, It last) {
+    size_type at = index_of(pos);
+    size_type old_size = size_;
+    for (; first != last; ++first)
+    {
+      if (size_ == N)
+      {
+        reset(old_size, size_);
+        size_ = old_size;
+        throw std::length_error("static_vector: capacity exceeded");
+      }
+      data_[size_++] = *first;
+    }
+    static_vector_detail::rotate(data_ + at, data_ + old_size, data_ + size_);
+    return data_ + at;
+  }
+  constexpr iterator insert(const_iterator pos, std::initializer_list<T> init) {
+    return insert(pos, init.begin(), init.end());
+  }
+
+  template <class... Args>
+  constexpr iterator emplace(const_iterator pos, Args&&... args) {
+    size_type at = index_of(pos);
+    check_capacity(size_ + 1);
+    T value(std::forward<Args>(args)...);
+    for (size_type i = size_; i > at; --i) data_[i] = std::move(data_[i - 1]);
+    data_[at] = std::move(value);
+    ++size_;
+    return data_ + at;
+  }
+
+  constexpr iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  constexpr iterator erase(const_iterator first, const_iterator last) {
+    size_type from = index_of(first);
+    size_type count = index_of(last) - from;
+    if (count == 0) return data_ + from;
+    for (size_type i = from; i + count < size_; ++i) data_[i] = std::move(data_[i + count]);
+    reset(size_ - count, size_);
+    size_ -= count;
+    return data_ + from;
+  }
+
+  constexpr void push_back(const T& value) { emplace_back(value); }
+  constexpr void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <class... Args>
+  constexpr reference emplace_back(Args&&... args) {
+    check_capacity(size_ + 1);
+    data_[size_] = T(std::forward<Args>(args)...);
+    return data_[size_++];
+  }
+
+  constexpr void pop_back() {
+    --size_;
+    data_[size_] = T();
+  }
+
+  // slots past size() already hold T()
+  constexpr void resize(size_type n) {
+    check_capacity(n);
+    reset(n, size_);
+    size_ = n;
+  }
+  constexpr void resize(size_type n, const T& value) {
+    check_capacity(n);
+    for (size_type i = size_; i < n; ++i) data_[i] = value;
+    reset(n, size_);
+    size_ = n;
+  }
+
+  constexpr void swap(static_vector& other) {
+    size_type n = size_ > other.size_ ? size_ : other.size_;
+    for (size_type i = 0; i < n; ++i) static_vector_detail::swap(data_[i], other.data_[i]);
+    size_type s = size_;
+    size_ = other.size_;
+    other.size_ = s;
+  }
+  friend constexpr void swap(static_vector& a, static_vector& b) { a.swap(b); }
+
+  friend constexpr bool operator==(const static_vector& a, const static_vector& b) {
+    if (a.size_ != b.size_) return false;
+    for (size_type i = 0; i < a.size_; ++i)
+      if (!(a.data_[i] == b.data_[i])) return false;
+    return true;
+  }
+  friend constexpr bool operator!=(const static_vector& a, const static_vector& b) { return !(a == b); }
+  friend constexpr bool operator<(const static_vector& a, const static_vector& b) {
+    for (size_type i = 0; i < a.size_ && i < b.size_; ++i)
+    {
+      if (a.data_[i] < b.data_[i]) return true;
+      if (b.data_[i] < a.data_[i]) return false;
+    }
+    return a.size_ < b.size_;
+  }
+  friend constexpr bool operator>(const static_vector& a, const static_vector& b) { return b < a; }
+  friend constexpr bool operator<=(const static_vector& a, const static_vector& b) { return !(b < a); }
+  friend constexpr bool operator>=(const static_vector& a, const static_vector& b) { return !(a < b); }
+
+private:
+  static constexpr void check_capacity(size_type n) {
+    if (n > N) throw std::length_error("static_vector: capacity exceeded");
+  }
+
+  constexpr size_type index_of(const_iterator pos) const noexcept { return size_type(pos - data_); }
+
+  // [first, last) back to T()
+  constexpr void reset(size_type first, size_type last) {
+    for (size_type i = first; i < last; ++i) data_[i] = T();
+  }
+
+  T data_[N == 0 ? 1 : N] {};
+  size_type size_ = 0;
+};
+
+#endif /* static_vector_hpp */
@@ -0,0 +1,310 @@
+//
+//  tracing.hpp
+//  vectors_in_cpp
+//
+// What?
+// Instrumentation that shows what a vector does behind capacity(), reserve() and shrink_to_fit():
+// - tracing_allocator<T>: counts allocations, frees and bytes, and through construct() every element
+//                         the vector copies or moves into its storage (including reallocation moves)
+// - traced<T>           : element wrapper that also counts copy/move assignments, which is how
+//                         insert()/erase() shift the elements that are already constructed
+// - trace_log           : per-section counters, a text report and a timeline in the Chrome trace
+//                         event format (load it in chrome://tracing or https://ui.perfetto.dev)
+//
+// How?
+// - std::vector<int, tracing_allocator<int>> v;
+// - std::vector<traced<big_record>, tracing_allocator<traced<big_record>>> w;
+// - trace_log::instance().begin_section("capacity"); ... trace_log::instance().end_section();
+// - trace_log::instance().write_report(std::cout);  trace_log::instance().write_chrome_trace(file);
+//
+// trace_log is a process wide singleton and not thread safe.
+
+#ifndef tracing_hpp
+#define tracing_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct trace_counters {
+  std::uint64_t allocations = 0;
+  std::uint64_t frees = 0;
+  std::uint64_t bytes_allocated = 0;
+  std::uint64_t bytes_freed = 0;
+  std::uint64_t copies = 0;
+  std::uint64_t moves = 0;
+  std::uint64_t bytes_copied = 0;
+  std::uint64_t bytes_moved = 0;
+
+  std::uint64_t live_bytes() const { return bytes_allocated - bytes_freed; }
+
+  trace_counters operator-(const trace_counters& rhs) const {
+    trace_counters d;
+    d.allocations = allocations - rhs.allocations;
+    d.frees = frees - rhs.frees;
+    d.bytes_allocated = bytes_allocated - rhs.bytes_allocated;
+    d.bytes_freed = bytes_freed - rhs.bytes_freed;
+    d.copies = copies - rhs.copies;
+    d.moves = moves - rhs.moves;
+    d.bytes_copied = bytes_copied - rhs.bytes_copied;
+    d.bytes_moved = bytes_moved - rhs.bytes_moved;
+    return d;
+  }
+};
+
+class trace_log {
+public:
+  struct section_record {
+    std::string name;
+    std::uint64_t begin_ns = 0;
+    std::uint64_t end_ns = 0;
+    trace_counters counters;
+  };
+
+  struct event {
+    enum kind_t { allocate, deallocate } kind;
+    std::uint64_t ts_ns;
+    const void* ptr;
+    std::uint64_t bytes;
+    trace_counters totals;   // cumulative counters right after the event
+  };
+
+  static trace_log& instance() {
+    static trace_log log;
+    return log;
+  }
+
+  // when disabled nothing is counted or recorded
+  void enable(bool on) { enabled_ = on; }
+  bool enabled() const { return enabled_; }
+  // allocation events for the timeline; counters are kept either way
+  void record_events(bool on) { record_events_ = on; }
+
+  void clear() {
+    totals_ = trace_counters();
+    sections_.clear();
+    events_.clear();
+    open_ = false;
+    origin_ = clock::now();
+  }
+
+  void begin_section(const char* name) {
+    end_section();
+    if (!enabled_) return;
+    open_ = true;
+    current_ = section_record();
+    current_.name = name;
+    current_.begin_ns = now_ns();
+    section_begin_ = totals_;
+  }
+
+  void end_section() {
+    if (!open_) return;
+    current_.end_ns = now_ns();
+    current_.counters = totals_ - section_begin_;
+    sections_.push_back(current_);
+    open_ = false;
+  }
+
+  void on_allocate(const void* p, std::size_t bytes) {
+    if (!enabled_) return;
+    ++totals_.allocations;
+    totals_.bytes_allocated += bytes;
+    if (record_events_) events_.push_back({event::allocate, now_ns(), p, bytes, totals_});
+  }
+  void on_deallocate(const void* p, std::size_t bytes) {
+    if (!enabled_) return;
+    ++totals_.frees;
+    totals_.bytes_freed += bytes;
+    if (record_events_) events_.push_back({event::deallocate, now_ns(), p, bytes, totals_});
+  }
+  void on_copy(std::size_t bytes) {
+    if (!enabled_) return;
+    ++totals_.copies;
+    totals_.bytes_copied += bytes;
+  }
+  void on_move(std::size_t bytes) {
+    if (!enabled_) return;
+    ++totals_.moves;
+    totals_.bytes_moved += bytes;
+  }
+
+  const trace_counters& totals() const { return totals_; }
+  const std::vector<section_record>& sections() const { return sections_; }
+  const std::vector<event>& events() const { return events_; }
+
+  void write_report(std::ostream& out) const {
+    out << std::left << std::setw(22) << "section" << std::right
+        << std::setw(8) << "allocs" << std::setw(8) << "frees" << std::setw(12) << "bytes"
+        << std::setw(8) << "copies" << std::setw(8) << "moves" << std::setw(14) << "bytes copied"
+        << std::setw(14) << "bytes moved" << '\n';
+    for (const section_record& s : sections_)
+    {
+      const trace_counters& c = s.counters;
+      out << std::left << std::setw(22) << s.name << std::right
+          << std::setw(8) << c.allocations << std::setw(8) << c.frees << std::setw(12) << c.bytes_allocated
+          << std::setw(8) << c.copies << std::setw(8) << c.moves << std::setw(14) << c.bytes_copied
+          << std::setw(14) << c.bytes_moved << '\n';
+    }
+  }
+
+  // Chrome trace event format: one complete ("X") event per section, an instant ("i") event per
+  // allocation/free and counter ("C") tracks for live bytes and for elements copied/moved so far
+  void write_chrome_trace(std::ostream& out) const {
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    auto sep = [&]() -> std::ostream& {
+      if (!first) out << ",\n";
+      first = false;
+      return out;
+    };
+    for (const section_record& s : sections_)
+    {
+      const trace_counters& c = s.counters;
+      sep() << "{\"name\": ";
+      write_json_string(out, s.name);
+      out << ", \"cat\": \"section\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+          << ", \"ts\": " << us(s.begin_ns) << ", \"dur\": " << us(s.end_ns - s.begin_ns)
+          << ", \"args\": {\"allocations\": " << c.allocations << ", \"frees\": " << c.frees
+          << ", \"bytes_allocated\": " << c.bytes_allocated << ", \"copies\": " << c.copies
+          << ", \"moves\": " << c.moves << ", \"bytes_copied\": " << c.bytes_copied
+          << ", \"bytes_moved\": " << c.bytes_moved << "}}";
+    }
+    for (const event& e : events_)
+    {
+      char ptr[32];
+      std::snprintf(ptr, sizeof(ptr), "%p", e.ptr);
+      sep() << "{\"name\": \"" << (e.kind == event::allocate ? "allocate" : "free")
+            << "\", \"cat\": \"memory\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": 1"
+            << ", \"ts\": " << us(e.ts_ns) << ", \"args\": {\"bytes\": " << e.bytes << ", \"ptr\": \"" << ptr << "\"}}";
+      sep() << "{\"name\": \"live bytes\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << us(e.ts_ns)
+            << ", \"args\": {\"live\": " << e.totals.live_bytes() << "}}";
+      sep() << "{\"name\": \"elements\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << us(e.ts_ns)
+            << ", \"args\": {\"copied\": " << e.totals.copies << ", \"moved\": " << e.totals.moves << "}}";
+    }
+    out << "\n]}\n";
+  }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  // a JSON string literal: quotes, backslashes and control characters escaped
+  static void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char ch : text)
+    {
+      if (ch == '"' || ch == '\\') out << '\\' << ch;
+      else if (static_cast<unsigned char>(ch) < 0x20)
+      {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(static_cast<unsigned char>(ch)));
+        out << escaped;
+      }
+      else out << ch;
+    }
+    out << '"';
+  }
+
+  trace_log() : origin_(clock::now()) {}
+
+  std::uint64_t now_ns() const {
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - origin_).count());
+  }
+  static double us(std::uint64_t ns) { return double(ns) / 1000.0; }
+
+  bool enabled_ = true;
+  bool record_events_ = true;
+  bool open_ = false;
+  clock::time_point origin_;
+  trace_counters totals_;
+  trace_counters section_begin_;
+  section_record current_;
+  std::vector<section_record> sections_;
+  std::vector<event> events_;
+};
+
+
+// tracing_allocator
+//  std::allocator plus bookkeeping. construct() sees every element the container builds in its storage:
+//  a single argument of the element type is a copy (lvalue) or a move (rvalue), anything else is a plain construction.
+template <class T>
+struct tracing_allocator {
+  using value_type = T;
+
+  tracing_allocator() noexcept = default;
+  template <class U> tracing_allocator(const tracing_allocator<U>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    T* p = std::allocator<T>().allocate(n);
+    trace_log::instance().on_allocate(p, n * sizeof(T));
+    return p;
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    trace_log::instance().on_deallocate(p, n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U, class... Args>
+  void construct(U* p, Args&&... args) {
+    if constexpr (sizeof...(Args) == 1) {
+      using arg = std::tuple_element_t<0, std::tuple<Args...>>;
+      if constexpr (std::is_same<std::decay_t<arg>, U>::value) {
+        if (std::is_lvalue_reference<arg>::value) trace_log::instance().on_copy(sizeof(U));
+        else trace_log::instance().on_move(sizeof(U));
+      }
+    }
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+  template <class U>
+  void destroy(U* p) noexcept { p->~U(); }
+
+  friend bool operator==(const tracing_allocator&, const tracing_allocator&) noexcept { return true; }
+  friend bool operator!=(const tracing_allocator&, const tracing_allocator&) noexcept { return false; }
+};
+
+
+// traced<T>
+//  Counts copy and move assignments of the wrapped value. Copy and move constructions are not
+//  counted here: use it together with tracing_allocator, whose construct() already sees them.
+template <class T>
+class traced {
+public:
+  traced() = default;
+  traced(const T& value) : value_(value) {}
+  traced(T&& value) : value_(std::move(value)) {}
+
+  traced(const traced& other) : value_(other.value_) {}
+  traced(traced&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : value_(std::move(other.value_)) {}
+  traced& operator=(const traced& other) {
+    trace_log::instance().on_copy(sizeof(traced));
+    value_ = other.value_;
+    return *this;
+  }
+  traced& operator=(traced&& other) noexcept(std::is_nothrow_move_assignable<T>::value) {
+    trace_log::instance().on_move(sizeof(traced));
+    value_ = std::move(other.value_);
+    return *this;
+  }
+
+  T& get() noexcept { return value_; }
+  const T& get() const noexcept { return value_; }
+  operator const T&() const noexcept { return value_; }
+
+  friend bool operator==(const traced& a, const traced& b) { return a.value_ == b.value_; }
+  friend bool operator!=(const traced& a, const traced& b) { return !(a.value_ == b.value_); }
+  friend bool operator<(const traced& a, const traced& b) { return a.value_ < b.value_; }
+
+private:
+  T value_ {};
+};
+
+#endif /* tracing_hpp */
@@ -0,0 +1,306 @@
+//
+//  vector_io.hpp
+//  vectors_in_cpp
+//
+// What?
+// Binary serialization of vectors of trivially copyable elements as length-prefixed frames, instead
+// of formatting every element through std::cout as the sections of main.cpp do. A frame is a 32-byte
+// header (magic, version, byte order, element size, element count, optional CRC-32C of the payload)
+// followed by the raw elements, so writing and reading copy bytes and never format or parse.
+// - vector_io::write(fd, v [, checksum::crc32c]) : one frame, header and elements in one writev()
+//                                                   straight from v.data()
+// - vector_io::frame_writer   : several frames gathered into as few writev() calls as possible
+// - vector_io::read(fd, v)    : the next frame into v (resized), read straight into v.data()
+// - vector_io::frame_reader   : frame by frame, a chunk of elements at a time, for frames larger
+//                               than memory; the checksum is verified as the last chunk is read
+//
+// How?
+// - vector_io::write(fd, vec_at, vector_io::checksum::crc32c);
+// - std::vector<int> back;  while (vector_io::read(fd, back)) ...;
+// - vector_io::frame_reader in (fd);  int chunk[4096];
+//   while (in.next()) while (std::size_t n = in.read(chunk, 4096)) use(chunk, n);
+// fd is any file descriptor: a file, a pipe, a socket. System call failures throw std::system_error,
+// frames that are malformed, truncated, of another element size or byte order, or fail their checksum
+// throw std::runtime_error. Frames are not portable between byte orders (the reader refuses them).
+// POSIX only; the checksum comes from simd_kernels.cpp, which has to be built in.
+
+#ifndef vector_io_hpp
+#define vector_io_hpp
+
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace vector_io {
+
+enum class checksum { none, crc32c };
+
+struct frame_header {
+  char magic[4];
+  std::uint16_t version;
+  std::uint16_t flags;           // has_checksum
+  std::uint32_t byte_order;      // byte_order_mark as written by the writing machine
+  std::uint32_t element_size;
+  std::uint64_t count;           // elements in the payload
+  std::uint32_t checksum;        // CRC-32C of the payload when flags has has_checksum, else 0
+  std::uint32_t reserved;
+};
+static_assert(sizeof(frame_header) == 32, "the header layout is part of the format");
+
+namespace detail {
+
+constexpr char magic[4] = {'V', 'E', 'C', 'F'};
+constexpr std::uint16_t version = 1;
+constexpr std::uint16_t has_checksum = 1;
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+[[noreturn]] inline void throw_errno(const char* what) {
+  throw std::system_error(errno, std::generic_category(), std::string("vector_io: ") + what);
+}
+
+[[noreturn]] inline void throw_bad(const char* what) { throw std::runtime_error(std::string("vector_io: ") + what); }
+
+inline frame_header make_header(std::size_t element_size, std::size_t count, const void* data, checksum c) {
+  frame_header h {};
+  std::memcpy(h.magic, magic, sizeof(magic));
+  h.version = version;
+  h.byte_order = byte_order_mark;
+  h.element_size = std::uint32_t(element_size);
+  h.count = count;
+  if (c == checksum::crc32c)
+  {
+    h.flags = has_checksum;
+    h.checksum = simd::crc32c(0, data, element_size * count);
+  }
+  return h;
+}
+
+// writes every byte of iov[0, count), resuming after short writes and EINTR; iov is used up
+inline void writev_all(int fd, iovec* iov, std::size_t count) {
+  while (count > 0)
+  {
+    ssize_t w = ::writev(fd, iov, int(std::min<std::size_t>(count, IOV_MAX)));
+    if (w < 0)
+    {
+      if (errno == EINTR) continue;
+      throw_errno("writev");
+    }
+    std::size_t done = std::size_t(w);
+    while (count > 0 && done >= iov->iov_len)
+    {
+      done -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0)
+    {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+      iov->iov_len -= done;
+    }
+  }
+}
+
+// reads exactly n bytes; returns how many were read before end of file (n unless the input ended)
+inline std::size_t read_full(int fd, void* p, std::size_t n) {
+  char* out = static_cast<char*>(p);
+  std::size_t done = 0;
+  while (done < n)
+  {
+    ssize_t r = ::read(fd, out + done, std::min<std::size_t>(n - done, SSIZE_MAX));
+    if (r < 0)
+    {
+      if (errno == EINTR) continue;
+      throw_errno("read");
+    }
+    if (r == 0) break;
+    done += std::size_t(r);
+  }
+  return done;
+}
+
+// false at a clean end of input (no byte of a new header)
+inline bool read_header(int fd, frame_header& h) {
+  std::size_t got = read_full(fd, &h, sizeof(h));
+  if (got == 0) return false;
+  if (got < sizeof(h)) throw_bad("truncated frame header");
+  if (std::memcmp(h.magic, magic, sizeof(magic)) != 0) throw_bad("not a vector_io frame");
+  if (h.version != version) throw_bad("unsupported version");
+  if (h.byte_order != byte_order_mark) throw_bad("written with another byte order");
+  if (h.element_size == 0 || h.count > SIZE_MAX / h.element_size) throw_bad("malformed frame header");
+  return true;
+}
+
+// false unless fd is a regular file with at least bytes left after the current position, in which
+// case the payload can be read in one go; a file too short for them is a truncated frame
+inline bool payload_fits(int fd, std::size_t bytes) {
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+  off_t at = ::lseek(fd, 0, SEEK_CUR);
+  if (at < 0) return false;
+  if (st.st_size < at || std::uint64_t(st.st_size - at) < bytes) throw_bad("truncated frame");
+  return true;
+}
+
+// how much read() grows a vector at a time when the input size is unknown
+constexpr std::size_t read_step = std::size_t(1) << 20;
+
+} // namespace detail
+
+// one frame of n elements from p
+template <class T>
+void write(int fd, const T* p, std::size_t n, checksum c = checksum::none) {
+  static_assert(std::is_trivially_copyable<T>::value, "vector_io writes the bytes of the elements");
+  frame_header h = detail::make_header(sizeof(T), n, p, c);
+  iovec iov[2] = {{&h, sizeof(h)}, {const_cast<T*>(p), n * sizeof(T)}};
+  detail::writev_all(fd, iov, n ? 2 : 1);
+}
+
+// one frame of a contiguous vector (std::vector, small_vector, static_vector, mmap_vector ...)
+template <class Vec>
+void write(int fd, const Vec& v, checksum c = checksum::none) {
+  write(fd, v.data(), v.size(), c);
+}
+
+// Gathers frames and writes them with writev(), IOV_MAX buffers at a time. Only the headers are
+// copied: the elements must stay in place until flush(), which the destructor does not call.
+class frame_writer {
+public:
+  explicit frame_writer(int fd, checksum c = checksum::none) : fd_(fd), checksum_(c) {}
+
+  template <class T>
+  void add(const T* p, std::size_t n) {
+    static_assert(std::is_trivially_copyable<T>::value, "vector_io writes the bytes of the elements");
+    headers_.push_back(detail::make_header(sizeof(T), n, p, checksum_));
+    iov_.push_back({&headers_.back(), sizeof(frame_header)});
+    if (n) iov_.push_back({const_cast<T*>(p), n * sizeof(T)});
+  }
+  template <class Vec>
+  void add(const Vec& v) { add(v.data(), v.size()); }
+
+  std::size_t pending_frames() const noexcept { return headers_.size(); }
+
+  void flush() {
+    detail::writev_all(fd_, iov_.data(), iov_.size());
+    iov_.clear();
+    headers_.clear();
+  }
+
+private:
+  int fd_;
+  checksum checksum_;
+  std::deque<frame_header> headers_;   // stable addresses for iov_
+  std::vector<iovec> iov_;
+};
+
+// The next frame into v, read straight into v.data(); false at the end of input. v keeps what it had
+// when the input ends before the first header byte. From a regular file the payload size is checked
+// against the file first; from anything else v grows 1 MiB at a time as the payload arrives, so a
+// corrupt count fails as a truncated frame instead of allocating what it claims.
+template <class Vec>
+bool read(int fd, Vec& v) {
+  using T = typename Vec::value_type;
+  static_assert(std::is_trivially_copyable<T>::value, "vector_io reads the bytes of the elements");
+  frame_header h;
+  if (!detail::read_header(fd, h)) return false;
+  if (h.element_size != sizeof(T)) detail::throw_bad("element size mismatch");
+  const std::size_t count = std::size_t(h.count);
+  const std::size_t bytes = count * sizeof(T);
+  if (detail::payload_fits(fd, bytes))
+  {
+    v.resize(count);
+    if (detail::read_full(fd, v.data(), bytes) != bytes) detail::throw_bad("truncated frame");
+  }
+  else
+  {
+    // a pipe or socket: count is not trusted until the elements arrive, so v grows as they do
+    const std::size_t step = std::max<std::size_t>(1, detail::read_step / sizeof(T));
+    v.resize(0);
+    for (std::size_t done = 0; done < count;)
+    {
+      std::size_t n = std::min(step, count - done);
+      v.resize(done + n);
+      if (detail::read_full(fd, v.data() + done, n * sizeof(T)) != n * sizeof(T)) detail::throw_bad("truncated frame");
+      done += n;
+    }
+  }
+  if ((h.flags & detail::has_checksum) && simd::crc32c(0, v.data(), bytes) != h.checksum) detail::throw_bad("checksum mismatch");
+  return true;
+}
+
+// Frame by frame, in chunks the caller provides, so a frame never has to fit in memory.
+class frame_reader {
+public:
+  explicit frame_reader(int fd) noexcept : fd_(fd) {}
+
+  // moves to the next frame, skipping what is left of the current one; false at the end of input
+  bool next() {
+    skip_rest();
+    if (!detail::read_header(fd_, header_)) return false;
+    left_ = header_.count;
+    crc_ = 0;
+    return true;
+  }
+
+  const frame_header& header() const noexcept { return header_; }
+  std::uint64_t count() const noexcept { return header_.count; }
+  std::uint64_t remaining() const noexcept { return left_; }
+
+  // up to max elements of the current frame into out; 0 once the frame is used up
+  template <class T>
+  std::size_t read(T* out, std::size_t max) {
+    static_assert(std::is_trivially_copyable<T>::value, "vector_io reads the bytes of the elements");
+    if (header_.element_size != sizeof(T)) detail::throw_bad("element size mismatch");
+    std::size_t n = std::size_t(std::min<std::uint64_t>(max, left_));
+    if (n == 0) return 0;
+    consume(out, n * sizeof(T), n == left_);
+    left_ -= n;
+    return n;
+  }
+
+private:
+  void consume(void* p, std::size_t bytes, bool last) {
+    if (detail::read_full(fd_, p, bytes) != bytes) detail::throw_bad("truncated frame");
+    if (header_.flags & detail::has_checksum)
+    {
+      crc_ = simd::crc32c(crc_, p, bytes);
+      if (last && crc_ != header_.checksum) detail::throw_bad("checksum mismatch");
+    }
+  }
+
+  // reads through (and checks) the unread rest of the current frame
+  void skip_rest() {
+    char buffer[4096];
+    std::uint64_t bytes = left_ * header_.element_size;
+    while (bytes > 0)
+    {
+      std::size_t n = std::size_t(std::min<std::uint64_t>(sizeof(buffer), bytes));
+      consume(buffer, n, n == bytes);
+      bytes -= n;
+    }
+    left_ = 0;
+  }
+
+  int fd_;
+  frame_header header_ {};
+  std::uint64_t left_ = 0;
+  std::uint32_t crc_ = 0;
+};
+
+} // namespace vector_io
+
+#endif /* vector_io_hpp */